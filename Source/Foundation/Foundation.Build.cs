@@ -19,6 +19,17 @@ public class Foundation : ModuleRules
 		
 		bEnableExceptions = true;
 
+		// base64+zstd account data needs zstd, found in ThirdParty/zstd when present. Without it base64 is requested instead.
+		string ZstdPath = Path.Combine(ModuleDirectory, "ThirdParty", "zstd");
+		bool bWithZstd = Directory.Exists(ZstdPath);
+		PublicDefinitions.Add("FOUNDATION_WITH_ZSTD=" + (bWithZstd ? "1" : "0"));
+		if (bWithZstd)
+		{
+			PrivateIncludePaths.Add(Path.Combine(ZstdPath, "include"));
+			PublicAdditionalLibraries.Add(Path.Combine(ZstdPath, "lib", Target.Platform.ToString(),
+				Target.Platform == UnrealTargetPlatform.Win64 ? "zstd_static.lib" : "libzstd.a"));
+		}
+
 		if (Target.Platform == UnrealTargetPlatform.Win64)
 		{
 			PublicDefinitions.Add("_CRT_SECURE_NO_WARNINGS");
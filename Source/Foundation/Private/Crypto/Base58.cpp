@@ -17,10 +17,7 @@ Author: Jon Sawler
 */
 #include "Crypto/Base58.h"
 
-#include "CryptoUtils.h"
-#include "Math/BigInt.h"
-
-const char ALPHABET[58] = {
+constexpr char ALPHABET[58] = {
 	'1', '2', '3', '4', '5', '6', '7', '8',
 	'9', 'A', 'B', 'C', 'D', 'E', 'F', 'G',
 	'H', 'J', 'K', 'L', 'M', 'N', 'P', 'Q',
@@ -31,58 +28,280 @@ const char ALPHABET[58] = {
 	'y', 'z'
 };
 
-TArray<uint8> FBase58::DecodeBase58(const FString& encoded)
+// Digits are converted five at a time, 58^5 being the largest power of 58 that fits a 32 bit limb.
+constexpr int32 DigitsPerLimb = 5;
+constexpr uint32 Pow58[DigitsPerLimb + 1] = { 1, 58, 3364, 195112, 11316496, 656356768 };
+
+struct FBase58DigitTable
 {
-	TArray<uint8> result;
-	
-	char* s = TCHAR_TO_UTF8(*encoded);
-	FString alphabet = ALPHABET;
-	
-	TBigInt<1024> intData;
-	for (int i = 0; i < encoded.Len(); i++)
-	{
-		int digit = -1;
-		unsigned char temp = s[i];
-		if (!alphabet.FindChar(temp, digit) || digit < 0 )
+	int8 Values[256];
+
+	constexpr FBase58DigitTable() : Values{}
+	{
+		for (int32 i = 0; i < 256; i++)
+		{
+			Values[i] = -1;
+		}
+		for (int32 i = 0; i < 58; i++)
+		{
+			Values[static_cast<uint8>(ALPHABET[i])] = static_cast<int8>(i);
+		}
+	}
+};
+
+static constexpr FBase58DigitTable DigitTable;
+
+// limbs must hold (size + 3) / 4 entries and digits MaxEncodedLength(size) + DigitsPerLimb.
+static int32 Encode(const uint8* data, int32 size, uint32* limbs, uint8* digits, TCHAR* out)
+{
+	int32 zeros = 0;
+	while (zeros < size && data[zeros] == 0)
+	{
+		zeros++;
+	}
+
+	// Big endian limbs, the first one padded with zero bytes.
+	const int32 numLimbs = (size + 3) / 4;
+	const int32 pad = numLimbs * 4 - size;
+	FMemory::Memzero(limbs, numLimbs * sizeof(uint32));
+	for (int32 i = 0; i < size; i++)
+	{
+		const int32 position = i + pad;
+		limbs[position / 4] |= static_cast<uint32>(data[i]) << (8 * (3 - position % 4));
+	}
+
+	// Each pass divides by 58^5 and yields five digits, least significant first.
+	int32 numDigits = 0;
+	int32 first = zeros / 4;
+	while (first < numLimbs && limbs[first] == 0)
+	{
+		first++;
+	}
+	while (first < numLimbs)
+	{
+		uint64 remainder = 0;
+		for (int32 i = first; i < numLimbs; i++)
+		{
+			const uint64 value = (remainder << 32) | limbs[i];
+			limbs[i] = static_cast<uint32>(value / Pow58[DigitsPerLimb]);
+			remainder = value % Pow58[DigitsPerLimb];
+		}
+		while (first < numLimbs && limbs[first] == 0)
+		{
+			first++;
+		}
+
+		uint32 group = static_cast<uint32>(remainder);
+		for (int32 k = 0; k < DigitsPerLimb; k++)
 		{
-			//Error
+			digits[numDigits++] = group % 58;
+			group /= 58;
 		}
-		intData = intData * 58 + digit;
 	}
-	
-	uint32* bits = intData.GetBits();
-	const int bitEndIndex = (1024 / 32) - 1;
-	for(int k = bitEndIndex; k >= 0 ; k--)
+
+	// The most significant group is padded with zero digits.
+	while (numDigits > 0 && digits[numDigits - 1] == 0)
 	{
-		if(bits[k] != 0)
+		numDigits--;
+	}
+
+	int32 count = 0;
+	while (count < zeros)
+	{
+		out[count++] = TEXT('1');
+	}
+	while (numDigits > 0)
+	{
+		out[count++] = ALPHABET[digits[--numDigits]];
+	}
+	return count;
+}
+
+// Accumulate the digits into little endian limbs, failing on a bad character or once maxLimbs would overflow.
+static EBase58Error DecodeLimbs(const TCHAR* encoded, int32 length, uint32* limbs, int32 maxLimbs, int32& outNumLimbs)
+{
+	int32 numLimbs = 0;
+	int32 index = 0;
+
+	// The first group takes the odd digits so the others are all full.
+	int32 groupLength = length % DigitsPerLimb == 0 ? DigitsPerLimb : length % DigitsPerLimb;
+	while (index < length)
+	{
+		uint32 group = 0;
+		for (int32 k = 0; k < groupLength; k++, index++)
+		{
+			const uint32 character = static_cast<uint32>(encoded[index]);
+			const int8 digit = character < 256 ? DigitTable.Values[character] : -1;
+			if (digit < 0)
+			{
+				return EBase58Error::InvalidCharacter;
+			}
+			group = group * 58 + digit;
+		}
+
+		uint64 carry = group;
+		for (int32 i = 0; i < numLimbs; i++)
 		{
-			result.Append(FCryptoUtils::Int32ToDataArrayBE(bits[k]));
+			const uint64 value = static_cast<uint64>(limbs[i]) * Pow58[groupLength] + carry;
+			limbs[i] = static_cast<uint32>(value);
+			carry = value >> 32;
 		}
+		if (carry != 0)
+		{
+			if (numLimbs == maxLimbs)
+			{
+				return EBase58Error::WrongSize;
+			}
+			limbs[numLimbs++] = static_cast<uint32>(carry);
+		}
+		groupLength = DigitsPerLimb;
+	}
+
+	outNumLimbs = numLimbs;
+	return EBase58Error::None;
+}
+
+// Bytes needed for the value held in limbs, whose top limb is never zero.
+static int32 GetValueSize(const uint32* limbs, int32 numLimbs)
+{
+	if (numLimbs == 0)
+	{
+		return 0;
+	}
+	const uint32 top = limbs[numLimbs - 1];
+	const int32 topBytes = top >= (1u << 24) ? 4 : top >= (1u << 16) ? 3 : top >= (1u << 8) ? 2 : 1;
+	return (numLimbs - 1) * 4 + topBytes;
+}
+
+static void WriteValue(const uint32* limbs, int32 valueSize, uint8* out)
+{
+	for (int32 i = 0; i < valueSize; i++)
+	{
+		const int32 shift = valueSize - 1 - i;
+		out[i] = static_cast<uint8>(limbs[shift / 4] >> (8 * (shift % 4)));
 	}
+}
+
+static int32 CountLeadingOnes(const TCHAR* encoded, int32 length)
+{
+	int32 ones = 0;
+	while (ones < length && encoded[ones] == TEXT('1'))
+	{
+		ones++;
+	}
+	return ones;
+}
 
+TArray<uint8> FBase58::DecodeBase58(const FString& encoded)
+{
+	TArray<uint8> result;
+
+	const int32 length = encoded.Len();
+	TArray<uint32, TInlineAllocator<MaxFixedSize / 4 + 2>> limbs;
+	limbs.SetNumUninitialized(length / DigitsPerLimb + 2);
+
+	int32 numLimbs = 0;
+	if (DecodeLimbs(*encoded, length, limbs.GetData(), limbs.Num(), numLimbs) != EBase58Error::None)
+	{
+		return result;
+	}
+
+	const int32 ones = CountLeadingOnes(*encoded, length);
+	const int32 valueSize = GetValueSize(limbs.GetData(), numLimbs);
+	result.SetNumZeroed(ones + valueSize);
+	WriteValue(limbs.GetData(), valueSize, result.GetData() + ones);
 	return result;
 }
 
 FString FBase58::EncodeBase58(const uint8* data, int len)
 {
-	TBigInt<1024> intData = 0;
-	for (int i = 0; i < len; i++)
+	if (len <= MaxFixedSize)
+	{
+		TCHAR buffer[MaxEncodedLength(MaxFixedSize)];
+		const int32 count = EncodeFixed(data, len, buffer);
+		return FString(count, buffer);
+	}
+
+	TArray<uint32> limbs;
+	limbs.SetNumUninitialized((len + 3) / 4);
+	TArray<uint8> digits;
+	digits.SetNumUninitialized(MaxEncodedLength(len) + DigitsPerLimb);
+	TArray<TCHAR> buffer;
+	buffer.SetNumUninitialized(MaxEncodedLength(len));
+
+	const int32 count = Encode(data, len, limbs.GetData(), digits.GetData(), buffer.GetData());
+	return FString(count, buffer.GetData());
+}
+
+int32 FBase58::EncodeFixed(const uint8* data, int32 size, TCHAR* out)
+{
+	check(size <= MaxFixedSize);
+
+	uint32 limbs[MaxFixedSize / 4];
+	uint8 digits[MaxEncodedLength(MaxFixedSize) + DigitsPerLimb];
+	return Encode(data, size, limbs, digits, out);
+}
+
+EBase58Error FBase58::DecodeFixed(const TCHAR* encoded, int32 length, uint8* out, int32 size)
+{
+	check(size <= MaxFixedSize);
+
+	if (length > MaxEncodedLength(size))
 	{
-		intData = intData * 256 + data[i];
+		return EBase58Error::WrongSize;
 	}
 
-	std::string result = "";
-	while (intData.IsGreater(0))
+	uint32 limbs[MaxFixedSize / 4 + 1];
+	int32 numLimbs = 0;
+	const EBase58Error error = DecodeLimbs(encoded, length, limbs, UE_ARRAY_COUNT(limbs), numLimbs);
+	if (error != EBase58Error::None)
 	{
-		TBigInt<1024> remainder = intData % 58;
-		intData /= 58;
-		result = ALPHABET[remainder.ToInt()] + result;
+		return error;
 	}
-	
-	for (int i = 0; i < len && data[i] == 0; i++)
+
+	const int32 ones = CountLeadingOnes(encoded, length);
+	const int32 valueSize = GetValueSize(limbs, numLimbs);
+	if (ones + valueSize != size)
 	{
-		result = '1' + result;
+		return EBase58Error::WrongSize;
+	}
+
+	FMemory::Memzero(out, ones);
+	WriteValue(limbs, valueSize, out + ones);
+	return EBase58Error::None;
+}
+
+void FBase58::EncodeMany(const uint8* data, int32 count, int32 size, TArray<FString>& outEncoded)
+{
+	check(size <= MaxFixedSize);
+
+	outEncoded.Reset(count);
+
+	TCHAR buffer[MaxEncodedLength(MaxFixedSize)];
+	for (int32 i = 0; i < count; i++)
+	{
+		const int32 length = EncodeFixed(data + i * size, size, buffer);
+		outEncoded.Emplace(length, buffer);
+	}
+}
+
+EBase58Error FBase58::DecodeMany(TConstArrayView<FString> encoded, int32 size, TArray<uint8>& outData, int32* outFailedIndex)
+{
+	check(size <= MaxFixedSize);
+
+	outData.SetNumUninitialized(encoded.Num() * size);
+	for (int32 i = 0; i < encoded.Num(); i++)
+	{
+		const EBase58Error error = DecodeFixed(*encoded[i], encoded[i].Len(), outData.GetData() + i * size, size);
+		if (error != EBase58Error::None)
+		{
+			if (outFailedIndex)
+			{
+				*outFailedIndex = i;
+			}
+			outData.Reset();
+			return error;
+		}
 	}
-	
-	return result.c_str();
+	return EBase58Error::None;
 }
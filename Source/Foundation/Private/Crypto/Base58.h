@@ -19,10 +19,36 @@ Author: Jon Sawler
 
 #include "CoreMinimal.h"
 
-class FBase58
+enum class EBase58Error : uint8
+{
+	None,
+	// A character outside the base58 alphabet.
+	InvalidCharacter,
+	// The digits decode to more or fewer bytes than expected.
+	WrongSize
+};
+
+class FOUNDATION_API FBase58
 {
 public:
+
+	// Keys and signatures, the sizes with a fixed width codec.
+	static constexpr int32 MaxFixedSize = 64;
+
+	static constexpr int32 MaxEncodedLength(int32 size) { return size * 138 / 100 + 1; }
 	
 	static FString EncodeBase58( const uint8* data, int len);
+	// Returns an empty array for anything that is not base58.
 	static TArray<uint8> DecodeBase58( const FString& encoded);
+
+	// Encode size bytes, at most MaxFixedSize, into out without touching the heap.
+	// out must hold MaxEncodedLength(size) characters; the number written is returned.
+	static int32 EncodeFixed(const uint8* data, int32 size, TCHAR* out);
+	// Decode into exactly size bytes, at most MaxFixedSize. out is left undefined on error.
+	static EBase58Error DecodeFixed(const TCHAR* encoded, int32 length, uint8* out, int32 size);
+
+	// Encode count keys of size bytes each, stored back to back.
+	static void EncodeMany(const uint8* data, int32 count, int32 size, TArray<FString>& outEncoded);
+	// Decode keys of exactly size bytes each into outData, back to back. Stops at the first invalid one, whose index goes to outFailedIndex.
+	static EBase58Error DecodeMany(TConstArrayView<FString> encoded, int32 size, TArray<uint8>& outData, int32* outFailedIndex = nullptr);
 };
@@ -18,6 +18,7 @@ Author: Jon Sawler
 #include "CryptoUtils.h"
 
 #include "Crypto/ed25519/ed25519.h"
+#include "SolanaUtils/PublicKey.h"
 
 #define UI UI_ST
 THIRD_PARTY_INCLUDES_START
@@ -108,17 +109,17 @@ TArray<uint8> FCryptoUtils::GenerateSeed(const char* Mnemonic, int MnemonicSize,
 	return seed;
 }
 
-void FCryptoUtils::GenerateKeyPair(const TArray<uint8>& Seed, TArray<uint8>& OutPublicKey, TArray<uint8>& OutPrivateKey)
+void FCryptoUtils::GenerateKeyPair(const TArray<uint8>& Seed, FPublicKey& OutPublicKey, TArray<uint8>& OutPrivateKey)
 {
 	ed25519_create_keypair(OutPublicKey.GetData(), OutPrivateKey.GetData(), Seed.GetData());
 }
 
-void FCryptoUtils::SignMessage(TArray<uint8>& Signature, const TArray<uint8>& Message, const TArray<uint8>& PrivateKey)
+void FCryptoUtils::SignMessage(FSignature& Signature, TConstArrayView<uint8> Message, const TArray<uint8>& PrivateKey)
 {
 	ed25519_sign(Signature.GetData(), Message.GetData(), Message.Num(), PrivateKey.GetData());
 }
 
-void FCryptoUtils::VerifyMessage(const TArray<uint8>& Signature, const TArray<uint8>& Message,TArray<uint8>& PublicKey)
+void FCryptoUtils::VerifyMessage(const FSignature& Signature, const TArray<uint8>& Message, const FPublicKey& PublicKey)
 {
 	ed25519_verify(Signature.GetData(), Message.GetData(), Message.Num(), PublicKey.GetData());
 }
@@ -135,30 +136,6 @@ bool FCryptoUtils::RandomBytes(TArray<uint8>& Salt, int32 Length)
 	return (Length == 0);
 }
 
-TArray<uint8> FCryptoUtils::Int32ToDataArray(int32 integer)
-{
-	TArray<uint8> result;
-	result.Add((integer & 0xff));
-	result.Add((integer >> 8) & 0xff);
-	result.Add((integer >> 16) & 0xff);
-	result.Add((integer >> 24) & 0xff);
-	return result;
-}
-
-TArray<uint8> FCryptoUtils::Int64ToDataArray(int64 integer)
-{
-	TArray<uint8> result;
-	result.Add((integer & 0xff));
-	result.Add((integer >> 8) & 0xff);
-	result.Add((integer >> 16) & 0xff);
-	result.Add((integer >> 24) & 0xff);
-	result.Add((integer >> 32) & 0xff);
-	result.Add((integer >> 40) & 0xff);
-	result.Add((integer >> 48) & 0xff);
-	result.Add((integer >> 56) & 0xff);
-	return result;
-}
-
 TArray<uint8> FCryptoUtils::Int32ToDataArrayBE(int32 integer)
 {
 	TArray<uint8> result;
@@ -222,37 +199,6 @@ TArray<uint8> FCryptoUtils::FStringToUint8(const FString& string)
 	return result;
 }
 
-TArray<uint8> FCryptoUtils::ShortVectorEncodeLength(int32 len)
-{
-	TArray<uint8> output;
-	output.SetNum(10);
-
-	int32 remLen = len;
-	int32 cursor = 0;
-
-	for (;;)
-	{
-		int32 elem = remLen & 0x7f;
-		remLen >>= 7;
-		if (remLen == 0)
-		{
-			output[cursor] = elem;
-			break;
-		}
-		elem |= 0x80;
-		output[cursor] = elem;
-		cursor += 1;
-	}
-
-	TArray<uint8> bytes;
-	for (int i = 0; i < cursor + 1; i++)
-	{
-		bytes.Add(output[i]);
-
-	}
-	return bytes;
-}
-
 std::vector<unsigned char> aes_128_gcm_encrypt(const unsigned char* data, uint32 lenght, std::string key)
 {
 	size_t enc_length = lenght*3;
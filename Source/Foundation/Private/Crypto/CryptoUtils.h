@@ -18,6 +18,9 @@ Contributers: Daniele Calanna
 */
 #pragma once
 
+struct FPublicKey;
+struct FSignature;
+
 class FCryptoUtils
 {
 public:
@@ -29,16 +32,13 @@ public:
 	static TArray<uint8> HMAC_SHA512(const TArray<uint8>& Key, const TArray<uint8>& Data);
 
 	static TArray<uint8> GenerateSeed(const char* Mnemonic, int MnemonicSize, const unsigned char*  Salt, int SaltSize);
-	static void GenerateKeyPair(const TArray<uint8>& Seed, TArray<uint8>& OutPublicKey, TArray<uint8>& OutPrivateKey );
+	static void GenerateKeyPair(const TArray<uint8>& Seed, FPublicKey& OutPublicKey, TArray<uint8>& OutPrivateKey );
 
-	static void SignMessage(TArray<uint8>& Signature, const TArray<uint8>& Message, const TArray<uint8>& PrivateKey);
-	static void VerifyMessage(const TArray<uint8>& Signature, const TArray<uint8>& Message,TArray<uint8>& PublicKey);
+	static void SignMessage(FSignature& Signature, TConstArrayView<uint8> Message, const TArray<uint8>& PrivateKey);
+	static void VerifyMessage(const FSignature& Signature, const TArray<uint8>& Message, const FPublicKey& PublicKey);
 	
 	static bool RandomBytes(TArray<uint8>& Salt, int32 Length);
 
-	static TArray<uint8> Int32ToDataArray(int32 integer);
-	static TArray<uint8> Int64ToDataArray(int64 integer);
-
 	static TArray<uint8> Int32ToDataArrayBE(int32 integer);
 	static TArray<uint8> Int64ToDataArrayBE(int64 integer);
 
@@ -47,8 +47,6 @@ public:
 	
 	static TArray<uint8> FStringToUint8(const FString& string);
 
-	static TArray<uint8> ShortVectorEncodeLength(int32 len);
-
 	static TArray<uint8> EncryptAES128GCM(const TArray<uint8>& Data, const FString& Password);
 	static TArray<uint8> DecryptAES128GCM(const TArray<uint8>& EncryptedData, const FString& Password);
 };
@@ -17,16 +17,26 @@ limitations under the License.
 
 #include "Foundation.h"
 
+#include "Network/BlockhashProvider.h"
+#include "Network/ConfirmationTracker.h"
+#include "Network/RequestManager.h"
+#include "Network/SubscriptionManager.h"
+#include "Network/TransactionSender.h"
+
 #define LOCTEXT_NAMESPACE "FFoundationModule"
 
 void FFoundationModule::StartupModule()
 {
-
+	FRequestManager::Startup();
 }
 
 void FFoundationModule::ShutdownModule()
 {
-
+	FBlockhashProvider::Shutdown();
+	FTransactionSender::Shutdown();
+	FConfirmationTracker::Shutdown();
+	FSubscriptionManager::Shutdown();
+	FRequestManager::Shutdown();
 }
 
 #undef LOCTEXT_NAMESPACE
@@ -33,3 +33,47 @@ FString UFoundationSettings::GetNetworkURL() const
 	}
 	return NetworkURL;
 }
+
+TArray<FString> UFoundationSettings::GetNetworkURLs() const
+{
+	TArray<FString> URLs;
+	const FString NetworkURL = GetNetworkURL();
+	if (!NetworkURL.IsEmpty())
+	{
+		URLs.Add(NetworkURL);
+	}
+	if (const FSolanaEndpointList* Endpoints = NetworkEndpoints.Find(GetNetwork()))
+	{
+		for (const FString& URL : Endpoints->URLs)
+		{
+			if (!URL.IsEmpty())
+			{
+				URLs.AddUnique(URL);
+			}
+		}
+	}
+	if (URLs.Num() == 0)
+	{
+		URLs.Add(GetNetwork() == ESolanaNetwork::DevNet ? TEXT("https://api.devnet.solana.com") : TEXT("https://api.mainnet-beta.solana.com"));
+	}
+	return URLs;
+}
+
+FString UFoundationSettings::GetNetworkWebSocketURL() const
+{
+	if (const FString* WebSocketURLPtr = NetworkWebSocketURLs.Find(GetNetwork()))
+	{
+		return *WebSocketURLPtr;
+	}
+
+	FString WebSocketURL = GetNetworkURLs()[0];
+	if (WebSocketURL.StartsWith(TEXT("https://")))
+	{
+		WebSocketURL = TEXT("wss://") + WebSocketURL.RightChop(8);
+	}
+	else if (WebSocketURL.StartsWith(TEXT("http://")))
+	{
+		WebSocketURL = TEXT("ws://") + WebSocketURL.RightChop(7);
+	}
+	return WebSocketURL;
+}
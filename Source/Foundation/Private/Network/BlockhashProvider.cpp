@@ -0,0 +1,276 @@
+/*
+Copyright 2022 ATMTA, Inc.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+	http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+*/
+
+#include "Network/BlockhashProvider.h"
+
+#include "Containers/Ticker.h"
+#include "Network/RequestManager.h"
+#include "Network/RequestUtils.h"
+#include "Network/SolanaRpcClient.h"
+#include "SolanaUtils/Utils/Types.h"
+
+#include "FoundationSettings.h"
+
+// Without a recent block height, a blockhash is only handed out for this long. It stays valid for 150 blocks, roughly a minute.
+constexpr double BlockhashMaxAge = 30.0;
+
+// getLatestBlockhash answers with the height the blockhash stops being valid at, this many blocks past its own.
+constexpr uint64 BlockhashValidBlocks = 150;
+
+// Blocks left in hand for a transaction to be built, sent and land, about 16 seconds.
+constexpr uint64 BlockHeightMargin = 40;
+
+// Heights are extrapolated at one block per BlockTime from the last one seen, but only for BlockHeightMaxAge.
+// Blocks are rarely faster than this, so the estimate errs towards treating a blockhash as stale.
+constexpr double BlockTime = 0.4;
+constexpr double BlockHeightMaxAge = 10.0;
+
+// Background refresh stops when no blockhash has been asked for in this long.
+constexpr double BlockhashIdleTimeout = 120.0;
+
+// Blockhashes and block heights belong to a network, so each client gets its own.
+struct FClientBlockhash
+{
+	TWeakPtr<FSolanaRpcClient> Client;
+	FBlockhashInfo CachedBlockhash;
+	TArray<BlockhashCallback> Waiters;
+	int32 RefreshesInFlight = 0;
+	bool bUrgentRefreshInFlight = false;
+	double LastUseTime = 0.0;
+
+	uint64 KnownBlockHeight = 0;
+	double KnownBlockHeightTime = 0.0;
+};
+
+static TMap<const FSolanaRpcClient*, FClientBlockhash> Clients;
+static FTSTicker::FDelegateHandle RefreshTimerHandle;
+
+static TSharedRef<FSolanaRpcClient> ResolveClient(const TSharedPtr<FSolanaRpcClient>& Client)
+{
+	return Client.IsValid() ? Client.ToSharedRef() : FRequestManager::GetDefaultClient();
+}
+
+static FClientBlockhash& FindOrAddState(const TSharedRef<FSolanaRpcClient>& Client)
+{
+	FClientBlockhash& State = Clients.FindOrAdd(&Client.Get());
+	// A client freed since may have left its address, and its state, behind.
+	if( State.Client.Pin() != Client )
+	{
+		State = FClientBlockhash();
+		State.Client = Client;
+	}
+	return State;
+}
+
+// The state of a client still alive, for responses that come back after it may have gone.
+static FClientBlockhash* FindState(const FSolanaRpcClient* Client)
+{
+	FClientBlockhash* State = Clients.Find(Client);
+	return State && State->Client.IsValid() ? State : nullptr;
+}
+
+static void UpdateBlockHeight(FClientBlockhash& State, uint64 BlockHeight, double Time)
+{
+	if( Time >= State.KnownBlockHeightTime )
+	{
+		State.KnownBlockHeight = BlockHeight;
+		State.KnownBlockHeightTime = Time;
+	}
+}
+
+static bool IsUsable(const FClientBlockhash& State, const FBlockhashInfo& Blockhash, double Now)
+{
+	if( !Blockhash.IsValid() )
+	{
+		return false;
+	}
+
+	if( State.KnownBlockHeight > 0 && Blockhash.LastValidBlockHeight > 0 && Now - State.KnownBlockHeightTime < BlockHeightMaxAge )
+	{
+		const uint64 BlockHeight = State.KnownBlockHeight + static_cast<uint64>((Now - State.KnownBlockHeightTime) / BlockTime);
+		return BlockHeight + BlockHeightMargin < Blockhash.LastValidBlockHeight;
+	}
+	return Now - Blockhash.FetchTime < BlockhashMaxAge;
+}
+
+static void FailWaiters(FClientBlockhash& State, const FString& Reason)
+{
+	// Another refresh still on its way may yet serve them.
+	if( State.RefreshesInFlight == 0 && State.Waiters.Num() > 0 )
+	{
+		State.Waiters.Empty();
+		FRequestUtils::DisplayError(Reason);
+	}
+}
+
+bool FBlockhashProvider::TryGetBlockhash(FBlockhashInfo& OutBlockhash, const TSharedPtr<FSolanaRpcClient>& Client)
+{
+	FClientBlockhash& State = FindOrAddState(ResolveClient(Client));
+	State.LastUseTime = FPlatformTime::Seconds();
+	if( !RefreshTimerHandle.IsValid() )
+	{
+		const float Interval = GetDefault<UFoundationSettings>()->GetBlockhashRefreshInterval();
+		RefreshTimerHandle = FTSTicker::GetCoreTicker().AddTicker(FTickerDelegate::CreateStatic(&FBlockhashProvider::OnRefreshTimer), Interval);
+	}
+
+	if( IsUsable(State, State.CachedBlockhash, State.LastUseTime) )
+	{
+		OutBlockhash = State.CachedBlockhash;
+		return true;
+	}
+	return false;
+}
+
+void FBlockhashProvider::GetBlockhash(BlockhashCallback Callback, const TSharedPtr<FSolanaRpcClient>& Client)
+{
+	const TSharedRef<FSolanaRpcClient> RpcClient = ResolveClient(Client);
+
+	FBlockhashInfo Blockhash;
+	if( TryGetBlockhash(Blockhash, RpcClient) )
+	{
+		Callback(Blockhash);
+		return;
+	}
+
+	FindOrAddState(RpcClient).Waiters.Add(MoveTemp(Callback));
+	Refresh(RpcClient);
+}
+
+void FBlockhashProvider::Refresh(const TSharedPtr<FSolanaRpcClient>& Client)
+{
+	const TSharedRef<FSolanaRpcClient> RpcClient = ResolveClient(Client);
+	FClientBlockhash& State = FindOrAddState(RpcClient);
+
+	// A transaction waiting on it does not queue behind a background refresh already sent, it sends its own.
+	const bool bUrgent = State.Waiters.Num() > 0;
+	if( bUrgent ? State.bUrgentRefreshInFlight : State.RefreshesInFlight > 0 )
+	{
+		return;
+	}
+	State.RefreshesInFlight++;
+	State.bUrgentRefreshInFlight |= bUrgent;
+
+	const FSolanaRpcClient* ClientPtr = &RpcClient.Get();
+	FRequestData* request = FRequestUtils::RequestBlockHash();
+	request->Priority = bUrgent ? ERequestPriority::Transaction : ERequestPriority::Background;
+	request->Callback.BindLambda([ClientPtr, bUrgent](FJsonObject& data)
+	{
+		FClientBlockhash* Received = FindState(ClientPtr);
+		if( Received == nullptr )
+		{
+			return;
+		}
+		Received->RefreshesInFlight--;
+		Received->bUrgentRefreshInFlight &= !bUrgent;
+
+		const FLatestBlockhashJson response = FRequestUtils::ParseLatestBlockHashResponse(data);
+
+		FBlockhashInfo Blockhash;
+		Blockhash.Blockhash = response.value.blockhash;
+		Blockhash.LastValidBlockHeight = static_cast<uint64>(response.value.lastValidBlockHeight);
+		Blockhash.Slot = static_cast<uint64>(response.context.slot);
+		Blockhash.FetchTime = FPlatformTime::Seconds();
+		OnBlockhashReceived(*Received, Blockhash);
+	});
+	request->ErrorCallback.BindLambda([ClientPtr, bUrgent](const FText& FailureReason)
+	{
+		if( FClientBlockhash* Failed = FindState(ClientPtr) )
+		{
+			Failed->RefreshesInFlight--;
+			Failed->bUrgentRefreshInFlight &= !bUrgent;
+			FailWaiters(*Failed, FailureReason.ToString());
+		}
+	});
+	RpcClient->SendRequest(request);
+}
+
+void FBlockhashProvider::ReportBlockHeight(const FSolanaRpcClient* Client, uint64 BlockHeight)
+{
+	FClientBlockhash* State = FindState(Client);
+	if( State && BlockHeight > 0 )
+	{
+		UpdateBlockHeight(*State, BlockHeight, FPlatformTime::Seconds());
+	}
+}
+
+void FBlockhashProvider::Shutdown()
+{
+	if( RefreshTimerHandle.IsValid() )
+	{
+		FTSTicker::GetCoreTicker().RemoveTicker(RefreshTimerHandle);
+		RefreshTimerHandle.Reset();
+	}
+	Clients.Empty();
+}
+
+bool FBlockhashProvider::OnRefreshTimer(float DeltaTime)
+{
+	const double Now = FPlatformTime::Seconds();
+
+	TArray<TSharedRef<FSolanaRpcClient>> Active;
+	for( auto It = Clients.CreateIterator(); It; ++It )
+	{
+		const TSharedPtr<FSolanaRpcClient> Client = It->Value.Client.Pin();
+		if( !Client.IsValid() || (Now - It->Value.LastUseTime > BlockhashIdleTimeout && It->Value.RefreshesInFlight == 0) )
+		{
+			It.RemoveCurrent();
+			continue;
+		}
+		Active.Add(Client.ToSharedRef());
+	}
+
+	if( Clients.Num() == 0 )
+	{
+		RefreshTimerHandle.Reset();
+		return false;
+	}
+
+	for( const TSharedRef<FSolanaRpcClient>& Client : Active )
+	{
+		Refresh(Client);
+	}
+	return true;
+}
+
+void FBlockhashProvider::OnBlockhashReceived(FClientBlockhash& State, const FBlockhashInfo& Blockhash)
+{
+	if( !Blockhash.IsValid() )
+	{
+		FailWaiters(State, TEXT("Failed to get a recent blockhash"));
+		return;
+	}
+
+	// The processed blockhash is the newest block, so its height is known too.
+	if( Blockhash.LastValidBlockHeight > BlockhashValidBlocks )
+	{
+		UpdateBlockHeight(State, Blockhash.LastValidBlockHeight - BlockhashValidBlocks, Blockhash.FetchTime);
+	}
+
+	// Load balanced endpoints can answer from a node that is behind, keep the newer slot while it is usable.
+	if( !IsUsable(State, State.CachedBlockhash, Blockhash.FetchTime) || Blockhash.Slot >= State.CachedBlockhash.Slot )
+	{
+		State.CachedBlockhash = Blockhash;
+	}
+
+	// Waiters may ask for another blockhash, so the state is not touched once they run.
+	const FBlockhashInfo Ready = State.CachedBlockhash;
+	TArray<BlockhashCallback> ReadyWaiters = MoveTemp(State.Waiters);
+	for( const BlockhashCallback& Waiter : ReadyWaiters )
+	{
+		Waiter(Ready);
+	}
+}
@@ -0,0 +1,352 @@
+/*
+Copyright 2022 ATMTA, Inc.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+	http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+*/
+
+#include "Network/ConfirmationTracker.h"
+
+#include "Containers/Ticker.h"
+#include "Dom/JsonObject.h"
+#include "Network/RequestManager.h"
+#include "Network/SolanaRpcClient.h"
+#include "Network/SubscriptionManager.h"
+#include "SolanaUtils/Utils/TransactionUtils.h"
+
+#include "FoundationSettings.h"
+
+// A transaction that has not landed once its blockhash expires, 150 blocks later, never will.
+constexpr double PendingTimeout = 90.0;
+
+// Transactions that landed on a fork may never finalize. Stop following them eventually, without a callback:
+// they did land, so reporting them expired would be wrong.
+constexpr double TrackTimeout = 180.0;
+
+// Subscribed signatures are still polled now and then, notifications can be lost across a reconnect.
+constexpr double SubscribedPollInterval = 5.0;
+
+struct FTrackedSignature
+{
+	// Polled through the client the transaction was sent with, its network is the one that knows it.
+	TSharedPtr<FSolanaRpcClient> Client;
+	TArray<TransactionStatusCallback> Callbacks;
+	TArray<uint32> Subscriptions;
+	ETransactionStatus Status = ETransactionStatus::Pending;
+	bool bTimeout = true;
+	double TrackTime = 0.0;
+	double LastPollTime = 0.0;
+};
+
+static TMap<FString, FTrackedSignature> Tracked;
+static TSet<const FSolanaRpcClient*> PollsInFlight;
+static FTSTicker::FDelegateHandle PollTimerHandle;
+
+FString FConfirmationTracker::Track(const TArray<uint8>& Transaction, TransactionStatusCallback Callback, bool bTimeout, const TSharedPtr<FSolanaRpcClient>& Client)
+{
+	const FString Signature = FTransactionUtils::GetSignature(Transaction);
+	Track(Signature, MoveTemp(Callback), bTimeout, Client);
+	return Signature;
+}
+
+void FConfirmationTracker::Track(const FString& Signature, TransactionStatusCallback Callback, bool bTimeout, const TSharedPtr<FSolanaRpcClient>& Client)
+{
+	check(IsInGameThread());
+
+	if( Signature.IsEmpty() )
+	{
+		return;
+	}
+
+	FTrackedSignature* Entry = Tracked.Find(Signature);
+	if( Entry == nullptr )
+	{
+		Entry = &Tracked.Add(Signature);
+		Entry->Client = Client.IsValid() ? Client : TSharedPtr<FSolanaRpcClient>(FRequestManager::GetDefaultClient());
+		Entry->TrackTime = FPlatformTime::Seconds();
+		Entry->bTimeout = bTimeout;
+	}
+	else
+	{
+		Entry->bTimeout &= bTimeout;
+	}
+	Entry->Callbacks.Add(MoveTemp(Callback));
+
+	if( Entry->Subscriptions.Num() == 0 )
+	{
+		Subscribe(Signature);
+	}
+
+	if( !PollTimerHandle.IsValid() )
+	{
+		const float Interval = GetDefault<UFoundationSettings>()->GetConfirmationPollInterval();
+		PollTimerHandle = FTSTicker::GetCoreTicker().AddTicker(FTickerDelegate::CreateStatic(&FConfirmationTracker::OnPollTimer), Interval);
+	}
+}
+
+void FConfirmationTracker::Untrack(const FString& Signature)
+{
+	Remove(Signature);
+}
+
+void FConfirmationTracker::Fail(const FString& Signature)
+{
+	OnStatusReceived(Signature, ETransactionStatus::Failed);
+}
+
+void FConfirmationTracker::Expire(const FString& Signature)
+{
+	OnStatusReceived(Signature, ETransactionStatus::Expired);
+}
+
+bool FConfirmationTracker::IsTracking(const FString& Signature)
+{
+	return Tracked.Contains(Signature);
+}
+
+void FConfirmationTracker::Shutdown()
+{
+	if( PollTimerHandle.IsValid() )
+	{
+		FTSTicker::GetCoreTicker().RemoveTicker(PollTimerHandle);
+		PollTimerHandle.Reset();
+	}
+
+	for( const TPair<FString, FTrackedSignature>& Pair : Tracked )
+	{
+		for( const uint32 Handle : Pair.Value.Subscriptions )
+		{
+			FSubscriptionManager::Unsubscribe(Handle);
+		}
+	}
+	Tracked.Empty();
+	PollsInFlight.Empty();
+}
+
+bool FConfirmationTracker::OnPollTimer(float DeltaTime)
+{
+	const double Now = FPlatformTime::Seconds();
+
+	TArray<FString> ExpiredSignatures;
+	TArray<FString> AbandonedSignatures;
+	for( const TPair<FString, FTrackedSignature>& Pair : Tracked )
+	{
+		const double Age = Now - Pair.Value.TrackTime;
+		if( Pair.Value.Status == ETransactionStatus::Pending )
+		{
+			if( Pair.Value.bTimeout && Age > PendingTimeout )
+			{
+				ExpiredSignatures.Add(Pair.Key);
+			}
+		}
+		else if( Age > TrackTimeout )
+		{
+			AbandonedSignatures.Add(Pair.Key);
+		}
+	}
+	for( const FString& Signature : ExpiredSignatures )
+	{
+		OnStatusReceived(Signature, ETransactionStatus::Expired);
+	}
+	for( const FString& Signature : AbandonedSignatures )
+	{
+		Remove(Signature);
+	}
+
+	if( Tracked.Num() == 0 )
+	{
+		PollTimerHandle.Reset();
+		return false;
+	}
+
+	// The socket may have come up since these were tracked.
+	if( FSubscriptionManager::IsConnected() )
+	{
+		for( const TPair<FString, FTrackedSignature>& Pair : Tracked )
+		{
+			if( Pair.Value.Subscriptions.Num() == 0 )
+			{
+				Subscribe(Pair.Key);
+			}
+		}
+	}
+
+	Poll();
+	return true;
+}
+
+void FConfirmationTracker::Poll()
+{
+	TArray<TSharedRef<FSolanaRpcClient>> Clients;
+	for( const TPair<FString, FTrackedSignature>& Pair : Tracked )
+	{
+		Clients.AddUnique(Pair.Value.Client.ToSharedRef());
+	}
+	for( const TSharedRef<FSolanaRpcClient>& Client : Clients )
+	{
+		Poll(Client);
+	}
+}
+
+void FConfirmationTracker::Poll(const TSharedRef<FSolanaRpcClient>& Client)
+{
+	const FSolanaRpcClient* ClientPtr = &Client.Get();
+	if( PollsInFlight.Contains(ClientPtr) )
+	{
+		return;
+	}
+
+	const double Now = FPlatformTime::Seconds();
+
+	TArray<FString> Signatures;
+	for( const TPair<FString, FTrackedSignature>& Pair : Tracked )
+	{
+		if( Pair.Value.Client == Client && (Pair.Value.Subscriptions.Num() == 0 || Now - Pair.Value.LastPollTime >= SubscribedPollInterval) )
+		{
+			Signatures.Add(Pair.Key);
+		}
+	}
+	if( Signatures.Num() == 0 )
+	{
+		return;
+	}
+
+	// One call per client and poll. The longest unpolled signatures go first when there are more than it can hold.
+	if( Signatures.Num() > MaxSignatureStatuses )
+	{
+		Signatures.Sort([](const FString& A, const FString& B)
+		{
+			return Tracked.FindChecked(A).LastPollTime < Tracked.FindChecked(B).LastPollTime;
+		});
+		Signatures.SetNum(MaxSignatureStatuses);
+	}
+	for( const FString& Signature : Signatures )
+	{
+		Tracked.FindChecked(Signature).LastPollTime = Now;
+	}
+
+	PollsInFlight.Add(ClientPtr);
+
+	FRequestData* request = FRequestUtils::RequestSignatureStatuses(Signatures);
+	request->Priority = ERequestPriority::Transaction;
+	request->Callback.BindLambda([ClientPtr, Signatures](FJsonObject& data)
+	{
+		PollsInFlight.Remove(ClientPtr);
+
+		const TArray<ETransactionStatus> Statuses = FRequestUtils::ParseSignatureStatusesResponse(data);
+		for( int32 Index = 0; Index < Statuses.Num() && Index < Signatures.Num(); Index++ )
+		{
+			OnStatusReceived(Signatures[Index], Statuses[Index]);
+		}
+	});
+	request->ErrorCallback.BindLambda([ClientPtr](const FText& FailureReason)
+	{
+		PollsInFlight.Remove(ClientPtr);
+	});
+	Client->SendRequest(request);
+}
+
+void FConfirmationTracker::Subscribe(const FString& Signature)
+{
+	// Opening the socket for this alone would cost more than polling. Use it only when it is already up.
+	if( !FSubscriptionManager::IsConnected() )
+	{
+		return;
+	}
+
+	// The socket follows the default network. Transactions sent elsewhere are only polled.
+	FTrackedSignature& Entry = Tracked.FindChecked(Signature);
+	if( Entry.Client != FRequestManager::GetDefaultClient() )
+	{
+		return;
+	}
+	const TPair<ETransactionStatus, const TCHAR*> Levels[] =
+	{
+		{ ETransactionStatus::Processed, TEXT("processed") },
+		{ ETransactionStatus::Confirmed, TEXT("confirmed") },
+		{ ETransactionStatus::Finalized, TEXT("finalized") }
+	};
+	for( const TPair<ETransactionStatus, const TCHAR*>& Level : Levels )
+	{
+		const ETransactionStatus Status = Level.Key;
+		Entry.Subscriptions.Add(FSubscriptionManager::SubscribeSignature(Signature, SubscriptionCallback::CreateLambda([Signature, Status](const FJsonObject& Result)
+		{
+			const TSharedPtr<FJsonObject>* Value;
+			TSharedPtr<FJsonValue> Error;
+			if( Result.TryGetObjectField("value", Value) )
+			{
+				Error = (*Value)->TryGetField("err");
+			}
+			OnStatusReceived(Signature, Error.IsValid() && !Error->IsNull() ? ETransactionStatus::Failed : Status);
+		}), Level.Value));
+	}
+}
+
+void FConfirmationTracker::OnStatusReceived(const FString& Signature, ETransactionStatus Status)
+{
+	FTrackedSignature* Entry = Tracked.Find(Signature);
+	if( Entry == nullptr || Status <= Entry->Status )
+	{
+		return;
+	}
+
+	// Only a transaction that never landed can expire. One already seen has its last status stand.
+	if( Status == ETransactionStatus::Expired && Entry->Status != ETransactionStatus::Pending )
+	{
+		return;
+	}
+
+	// Report every level passed since the last update, polls and notifications can skip some.
+	TArray<ETransactionStatus> Reached;
+	if( Status == ETransactionStatus::Failed || Status == ETransactionStatus::Expired )
+	{
+		Reached.Add(Status);
+	}
+	else
+	{
+		for( uint8 Level = static_cast<uint8>(Entry->Status) + 1; Level <= static_cast<uint8>(Status); Level++ )
+		{
+			Reached.Add(static_cast<ETransactionStatus>(Level));
+		}
+	}
+	Entry->Status = Status;
+
+	// Callbacks may track or untrack signatures, do not hold on to the entry.
+	const TArray<TransactionStatusCallback> Callbacks = Entry->Callbacks;
+	if( Status >= ETransactionStatus::Finalized )
+	{
+		Remove(Signature);
+	}
+
+	for( const ETransactionStatus Level : Reached )
+	{
+		for( const TransactionStatusCallback& Callback : Callbacks )
+		{
+			Callback.ExecuteIfBound(Signature, Level);
+		}
+	}
+}
+
+void FConfirmationTracker::Remove(const FString& Signature)
+{
+	FTrackedSignature Entry;
+	if( !Tracked.RemoveAndCopyValue(Signature, Entry) )
+	{
+		return;
+	}
+
+	for( const uint32 Handle : Entry.Subscriptions )
+	{
+		FSubscriptionManager::Unsubscribe(Handle);
+	}
+}
@@ -0,0 +1,324 @@
+/*
+Copyright 2022 ATMTA, Inc.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+	http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+*/
+#include "Network/JsonStreamReader.h"
+
+static bool IsWhitespaceOrSeparator(uint8 Char)
+{
+	return Char == ' ' || Char == '\t' || Char == '\n' || Char == '\r' || Char == ',' || Char == ':';
+}
+
+static bool IsNumberChar(uint8 Char)
+{
+	return (Char >= '0' && Char <= '9') || Char == '-' || Char == '+' || Char == '.' || Char == 'e' || Char == 'E';
+}
+
+static int32 HexValue(uint8 Char)
+{
+	if( Char >= '0' && Char <= '9' ) return Char - '0';
+	if( Char >= 'a' && Char <= 'f' ) return Char - 'a' + 10;
+	if( Char >= 'A' && Char <= 'F' ) return Char - 'A' + 10;
+	return -1;
+}
+
+FJsonStreamReader::FJsonStreamReader(const uint8* InData, int32 InSize)
+	: Data(InData), Size(InSize)
+{
+}
+
+EJsonStreamToken FJsonStreamReader::Next()
+{
+	if( Token == EJsonStreamToken::Error )
+	{
+		return Token;
+	}
+
+	bIsKey = false;
+	bHasEscapes = false;
+
+	while( Offset < Size && IsWhitespaceOrSeparator(Data[Offset]) )
+	{
+		Offset++;
+	}
+
+	TokenStart = Offset;
+	if( Offset >= Size )
+	{
+		Token = EJsonStreamToken::None;
+		return Token;
+	}
+
+	switch( Data[Offset] )
+	{
+	case '{': Offset++; Token = EJsonStreamToken::ObjectStart; break;
+	case '}': Offset++; Token = EJsonStreamToken::ObjectEnd; break;
+	case '[': Offset++; Token = EJsonStreamToken::ArrayStart; break;
+	case ']': Offset++; Token = EJsonStreamToken::ArrayEnd; break;
+	case 't': Token = MatchLiteral("true", 4) ? EJsonStreamToken::True : EJsonStreamToken::Error; break;
+	case 'f': Token = MatchLiteral("false", 5) ? EJsonStreamToken::False : EJsonStreamToken::Error; break;
+	case 'n': Token = MatchLiteral("null", 4) ? EJsonStreamToken::Null : EJsonStreamToken::Error; break;
+	case '"':
+		{
+			Offset++;
+			while( Offset < Size && Data[Offset] != '"' )
+			{
+				if( Data[Offset] == '\\' )
+				{
+					bHasEscapes = true;
+					Offset++;
+				}
+				Offset++;
+			}
+			if( Offset >= Size )
+			{
+				Token = EJsonStreamToken::Error;
+				break;
+			}
+			TokenEnd = Offset++;
+			Token = EJsonStreamToken::String;
+
+			int32 Lookahead = Offset;
+			while( Lookahead < Size && (Data[Lookahead] == ' ' || Data[Lookahead] == '\t' || Data[Lookahead] == '\n' || Data[Lookahead] == '\r') )
+			{
+				Lookahead++;
+			}
+			bIsKey = Lookahead < Size && Data[Lookahead] == ':';
+		}
+		break;
+	default:
+		if( !IsNumberChar(Data[Offset]) )
+		{
+			Token = EJsonStreamToken::Error;
+			break;
+		}
+		while( Offset < Size && IsNumberChar(Data[Offset]) )
+		{
+			Offset++;
+		}
+		TokenEnd = Offset;
+		Token = EJsonStreamToken::Number;
+		break;
+	}
+	return Token;
+}
+
+bool FJsonStreamReader::MatchLiteral(const ANSICHAR* Literal, int32 Length)
+{
+	if( Offset + Length > Size || FMemory::Memcmp(Data + Offset, Literal, Length) != 0 )
+	{
+		return false;
+	}
+	Offset += Length;
+	return true;
+}
+
+bool FJsonStreamReader::NextMember()
+{
+	Next();
+	return IsKey();
+}
+
+bool FJsonStreamReader::NextElement()
+{
+	const EJsonStreamToken Element = Next();
+	return Element != EJsonStreamToken::ArrayEnd && Element != EJsonStreamToken::None && Element != EJsonStreamToken::Error;
+}
+
+bool FJsonStreamReader::SkipValue()
+{
+	if( Token != EJsonStreamToken::ObjectStart && Token != EJsonStreamToken::ArrayStart )
+	{
+		return Token != EJsonStreamToken::Error && Token != EJsonStreamToken::None;
+	}
+
+	int32 Depth = 1;
+	while( Depth > 0 )
+	{
+		switch( Next() )
+		{
+		case EJsonStreamToken::ObjectStart:
+		case EJsonStreamToken::ArrayStart:
+			Depth++;
+			break;
+		case EJsonStreamToken::ObjectEnd:
+		case EJsonStreamToken::ArrayEnd:
+			Depth--;
+			break;
+		case EJsonStreamToken::None:
+		case EJsonStreamToken::Error:
+			return false;
+		default:
+			break;
+		}
+	}
+	return true;
+}
+
+bool FJsonStreamReader::KeyEquals(const ANSICHAR* Key) const
+{
+	const int32 Length = FCStringAnsi::Strlen(Key);
+	return IsKey() && TokenEnd - TokenStart - 1 == Length && FMemory::Memcmp(Data + TokenStart + 1, Key, Length) == 0;
+}
+
+FString FJsonStreamReader::GetString()
+{
+	if( Token != EJsonStreamToken::String )
+	{
+		return FString();
+	}
+
+	const ANSICHAR* Source = reinterpret_cast<const ANSICHAR*>(Data + TokenStart + 1);
+	int32 Length = TokenEnd - TokenStart - 1;
+	if( bHasEscapes )
+	{
+		if( !Unescape() )
+		{
+			return FString();
+		}
+		Source = Scratch.GetData();
+		Length = Scratch.Num();
+	}
+
+	const FUTF8ToTCHAR Converted(Source, Length);
+	return FString(Converted.Length(), Converted.Get());
+}
+
+bool FJsonStreamReader::Unescape()
+{
+	Scratch.Reset();
+	for( int32 Index = TokenStart + 1; Index < TokenEnd; Index++ )
+	{
+		const uint8 Char = Data[Index];
+		if( Char != '\\' )
+		{
+			Scratch.Add(Char);
+			continue;
+		}
+
+		if( ++Index >= TokenEnd )
+		{
+			return false;
+		}
+
+		switch( Data[Index] )
+		{
+		case 'b': Scratch.Add('\b'); break;
+		case 'f': Scratch.Add('\f'); break;
+		case 'n': Scratch.Add('\n'); break;
+		case 'r': Scratch.Add('\r'); break;
+		case 't': Scratch.Add('\t'); break;
+		case 'u':
+			{
+				auto ReadCodeUnit = [this](int32 At) -> int32
+				{
+					int32 Value = 0;
+					for( int32 Digit = 0; Digit < 4; Digit++ )
+					{
+						const int32 Hex = At + Digit < TokenEnd ? HexValue(Data[At + Digit]) : -1;
+						if( Hex < 0 )
+						{
+							return -1;
+						}
+						Value = (Value << 4) | Hex;
+					}
+					return Value;
+				};
+
+				int32 CodePoint = ReadCodeUnit(Index + 1);
+				if( CodePoint < 0 )
+				{
+					return false;
+				}
+				Index += 4;
+
+				// Characters outside the basic plane arrive as a surrogate pair.
+				if( CodePoint >= 0xD800 && CodePoint <= 0xDBFF && Index + 2 < TokenEnd && Data[Index + 1] == '\\' && Data[Index + 2] == 'u' )
+				{
+					const int32 Low = ReadCodeUnit(Index + 3);
+					if( Low >= 0xDC00 && Low <= 0xDFFF )
+					{
+						CodePoint = 0x10000 + ((CodePoint - 0xD800) << 10) + (Low - 0xDC00);
+						Index += 6;
+					}
+				}
+
+				if( CodePoint < 0x80 )
+				{
+					Scratch.Add(static_cast<ANSICHAR>(CodePoint));
+				}
+				else if( CodePoint < 0x800 )
+				{
+					Scratch.Add(static_cast<ANSICHAR>(0xC0 | (CodePoint >> 6)));
+					Scratch.Add(static_cast<ANSICHAR>(0x80 | (CodePoint & 0x3F)));
+				}
+				else if( CodePoint < 0x10000 )
+				{
+					Scratch.Add(static_cast<ANSICHAR>(0xE0 | (CodePoint >> 12)));
+					Scratch.Add(static_cast<ANSICHAR>(0x80 | ((CodePoint >> 6) & 0x3F)));
+					Scratch.Add(static_cast<ANSICHAR>(0x80 | (CodePoint & 0x3F)));
+				}
+				else
+				{
+					Scratch.Add(static_cast<ANSICHAR>(0xF0 | (CodePoint >> 18)));
+					Scratch.Add(static_cast<ANSICHAR>(0x80 | ((CodePoint >> 12) & 0x3F)));
+					Scratch.Add(static_cast<ANSICHAR>(0x80 | ((CodePoint >> 6) & 0x3F)));
+					Scratch.Add(static_cast<ANSICHAR>(0x80 | (CodePoint & 0x3F)));
+				}
+			}
+			break;
+		default:
+			// \" \\ and \/ stand for themselves.
+			Scratch.Add(Data[Index]);
+			break;
+		}
+	}
+	return true;
+}
+
+double FJsonStreamReader::GetNumber() const
+{
+	if( Token != EJsonStreamToken::Number )
+	{
+		return 0.0;
+	}
+
+	ANSICHAR Buffer[64];
+	const int32 Length = FMath::Min(TokenEnd - TokenStart, static_cast<int32>(UE_ARRAY_COUNT(Buffer)) - 1);
+	FMemory::Memcpy(Buffer, Data + TokenStart, Length);
+	Buffer[Length] = 0;
+	return FCStringAnsi::Atod(Buffer);
+}
+
+uint64 FJsonStreamReader::GetUInt64() const
+{
+	if( Token != EJsonStreamToken::Number )
+	{
+		return 0;
+	}
+
+	// Parse integers digit by digit so values above 2^53 keep every bit.
+	uint64 Value = 0;
+	for( int32 Index = TokenStart; Index < TokenEnd; Index++ )
+	{
+		const uint8 Char = Data[Index];
+		if( Char < '0' || Char > '9' )
+		{
+			return static_cast<uint64>(FMath::Max(GetNumber(), 0.0));
+		}
+		Value = Value * 10 + (Char - '0');
+	}
+	return Value;
+}
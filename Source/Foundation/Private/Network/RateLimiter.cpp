@@ -0,0 +1,127 @@
+/*
+Copyright 2022 ATMTA, Inc.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+	http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+*/
+#include "Network/RateLimiter.h"
+
+#include "FoundationSettings.h"
+
+DECLARE_LOG_CATEGORY_CLASS(RateLimiter, Log, All);
+
+struct FTokenBucket
+{
+	double Rate = 0.0;
+	double Tokens = 0.0;
+	double LastRefill = 0.0;
+	double BlockedUntil = 0.0;
+};
+
+// Rate never drops below this many requests per second, however often we are throttled.
+constexpr double MinRate = 0.5;
+
+// Requests per second won back for every successful request after a throttle.
+constexpr double RateRecoveryStep = 0.1;
+
+static TMap<FString, FTokenBucket> Buckets;
+
+static double GetConfiguredRate()
+{
+	return GetDefault<UFoundationSettings>()->GetRequestsPerSecond();
+}
+
+static FTokenBucket* GetBucket(const FString& URL, double Now)
+{
+	const double ConfiguredRate = GetConfiguredRate();
+	if( ConfiguredRate <= 0.0 )
+	{
+		return nullptr;
+	}
+
+	FTokenBucket* Bucket = Buckets.Find(URL);
+	if( !Bucket )
+	{
+		Bucket = &Buckets.Add(URL);
+		Bucket->Rate = ConfiguredRate;
+		Bucket->Tokens = ConfiguredRate;
+		Bucket->LastRefill = Now;
+	}
+
+	// Burst is capped at one second worth of requests.
+	Bucket->Rate = FMath::Min(Bucket->Rate, ConfiguredRate);
+	Bucket->Tokens = FMath::Min(Bucket->Tokens + (Now - Bucket->LastRefill) * Bucket->Rate, FMath::Max(Bucket->Rate, 1.0));
+	Bucket->LastRefill = Now;
+	return Bucket;
+}
+
+bool FRateLimiter::TryAcquire(const FString& URL)
+{
+	const double Now = FPlatformTime::Seconds();
+	FTokenBucket* Bucket = GetBucket(URL, Now);
+	if( !Bucket )
+	{
+		return true;
+	}
+
+	if( Bucket->BlockedUntil > Now || Bucket->Tokens < 1.0 )
+	{
+		return false;
+	}
+	Bucket->Tokens -= 1.0;
+	return true;
+}
+
+double FRateLimiter::GetWaitTime(const FString& URL)
+{
+	const double Now = FPlatformTime::Seconds();
+	const FTokenBucket* Bucket = GetBucket(URL, Now);
+	if( !Bucket )
+	{
+		return 0.0;
+	}
+
+	const double TokenWait = Bucket->Tokens >= 1.0 ? 0.0 : (1.0 - Bucket->Tokens) / Bucket->Rate;
+	return FMath::Max(TokenWait, Bucket->BlockedUntil - Now);
+}
+
+void FRateLimiter::OnSuccess(const FString& URL)
+{
+	if( FTokenBucket* Bucket = Buckets.Find(URL) )
+	{
+		Bucket->Rate = FMath::Min(Bucket->Rate + RateRecoveryStep, GetConfiguredRate());
+	}
+}
+
+void FRateLimiter::OnThrottled(const FString& URL, double RetryAfter)
+{
+	const double Now = FPlatformTime::Seconds();
+	FTokenBucket* Bucket = GetBucket(URL, Now);
+	if( !Bucket )
+	{
+		return;
+	}
+
+	Bucket->Rate = FMath::Max(Bucket->Rate * 0.5, MinRate);
+	Bucket->Tokens = 0.0;
+	if( RetryAfter > 0.0 )
+	{
+		Bucket->BlockedUntil = FMath::Max(Bucket->BlockedUntil, Now + RetryAfter);
+	}
+	UE_LOG(RateLimiter, Warning, TEXT("%s is throttling, slowing down to %.1f requests per second"), *URL, Bucket->Rate);
+}
+
+void FRateLimiter::Reset()
+{
+	Buckets.Empty();
+}
@@ -0,0 +1,227 @@
+/*
+Copyright 2022 ATMTA, Inc.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+	http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+*/
+
+#include "Network/RequestCache.h"
+
+#include "Network/RequestManager.h"
+
+#include "FoundationSettings.h"
+
+struct FRequestCacheEntry
+{
+	// One or the other, depending on whether the read binds a result.
+	TSharedPtr<const FJsonObject> Response;
+	TSharedPtr<const FRequestResult> Result;
+	TArray<FString> AccountKeys;
+	double StoreTime = 0.0;
+	uint64 Slot = 0;
+};
+
+constexpr int32 MaxEntriesBeforePrune = 512;
+
+static TMap<FString, FRequestCacheEntry> Entries;
+static TMultiMap<FString, FString> EntriesByAccount;
+static TMap<FString, uint64> MinSlotByAccount;
+static FRequestCacheStats Stats;
+
+static FString GetEntryKey(const FRequestData& Request, const FString& Scope)
+{
+	return Scope + Request.GetReadKey();
+}
+
+static uint64 GetResponseSlot(const FJsonObject& Response)
+{
+	const TSharedPtr<FJsonObject>* Result;
+	const TSharedPtr<FJsonObject>* Context;
+	double Slot = 0;
+	if( Response.TryGetObjectField("result", Result) && (*Result)->TryGetObjectField("context", Context) )
+	{
+		(*Context)->TryGetNumberField("slot", Slot);
+	}
+	return static_cast<uint64>(Slot);
+}
+
+static bool IsEntryValid(const FRequestCacheEntry& Entry, double Now)
+{
+	if( Now - Entry.StoreTime > GetDefault<UFoundationSettings>()->GetReadCacheTTL() )
+	{
+		return false;
+	}
+
+	for( const FString& PubKey : Entry.AccountKeys )
+	{
+		if( Entry.Slot < MinSlotByAccount.FindRef(PubKey) )
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+static void RemoveEntry(const FString& EntryKey)
+{
+	FRequestCacheEntry Entry;
+	if( Entries.RemoveAndCopyValue(EntryKey, Entry) )
+	{
+		for( const FString& PubKey : Entry.AccountKeys )
+		{
+			EntriesByAccount.RemoveSingle(PubKey, EntryKey);
+		}
+	}
+}
+
+bool FRequestCache::IsCacheable(const FRequestData& Request)
+{
+	return Request.AccountKeys.Num() > 0 && Request.Method != TEXT("sendTransaction") && GetDefault<UFoundationSettings>()->GetReadCacheTTL() > 0.f;
+}
+
+static const FRequestCacheEntry* FindEntry(const FRequestData& Request, const FString& Scope)
+{
+	if( !FRequestCache::IsCacheable(Request) )
+	{
+		return nullptr;
+	}
+
+	const FString EntryKey = GetEntryKey(Request, Scope);
+	if( const FRequestCacheEntry* Entry = Entries.Find(EntryKey) )
+	{
+		if( IsEntryValid(*Entry, FPlatformTime::Seconds()) )
+		{
+			Stats.Hits++;
+			return Entry;
+		}
+		RemoveEntry(EntryKey);
+	}
+
+	Stats.Misses++;
+	return nullptr;
+}
+
+static void StoreEntry(const FRequestData& Request, FRequestCacheEntry&& Entry, const FString& Scope)
+{
+	const double Now = FPlatformTime::Seconds();
+	if( Entries.Num() >= MaxEntriesBeforePrune )
+	{
+		TArray<FString> ExpiredKeys;
+		for( const TPair<FString, FRequestCacheEntry>& Pair : Entries )
+		{
+			if( !IsEntryValid(Pair.Value, Now) )
+			{
+				ExpiredKeys.Add(Pair.Key);
+			}
+		}
+		for( const FString& EntryKey : ExpiredKeys )
+		{
+			RemoveEntry(EntryKey);
+		}
+	}
+
+	Entry.AccountKeys = Request.AccountKeys;
+	Entry.StoreTime = Now;
+
+	// A node that is behind can answer with state older than what was already invalidated.
+	if( !IsEntryValid(Entry, Now) )
+	{
+		return;
+	}
+
+	const FString EntryKey = GetEntryKey(Request, Scope);
+	RemoveEntry(EntryKey);
+	for( const FString& PubKey : Entry.AccountKeys )
+	{
+		EntriesByAccount.Add(PubKey, EntryKey);
+	}
+	Entries.Add(EntryKey, MoveTemp(Entry));
+}
+
+TSharedPtr<FJsonObject> FRequestCache::Find(const FRequestData& Request, const FString& Scope)
+{
+	const FRequestCacheEntry* Entry = Request.ResultDecoder ? nullptr : FindEntry(Request, Scope);
+	if( !Entry )
+	{
+		return nullptr;
+	}
+
+	const TSharedPtr<FJsonObject> Copy = MakeShared<FJsonObject>();
+	FJsonObject::Duplicate(Entry->Response, Copy);
+	return Copy;
+}
+
+void FRequestCache::Store(const FRequestData& Request, const TSharedPtr<FJsonObject>& Response, const FString& Scope)
+{
+	if( Request.ResultDecoder || !IsCacheable(Request) || !Response.IsValid() )
+	{
+		return;
+	}
+
+	const TSharedPtr<FJsonObject> Copy = MakeShared<FJsonObject>();
+	FJsonObject::Duplicate(Response, Copy);
+
+	FRequestCacheEntry Entry;
+	Entry.Slot = GetResponseSlot(*Response);
+	Entry.Response = Copy;
+	StoreEntry(Request, MoveTemp(Entry), Scope);
+}
+
+TSharedPtr<const FRequestResult> FRequestCache::FindResult(const FRequestData& Request, const FString& Scope)
+{
+	const FRequestCacheEntry* Entry = Request.ResultDecoder ? FindEntry(Request, Scope) : nullptr;
+	return Entry ? Entry->Result : nullptr;
+}
+
+void FRequestCache::StoreResult(const FRequestData& Request, const TSharedPtr<const FRequestResult>& Result, uint64 Slot, const FString& Scope)
+{
+	if( !Request.ResultDecoder || !IsCacheable(Request) || !Result.IsValid() )
+	{
+		return;
+	}
+
+	FRequestCacheEntry Entry;
+	Entry.Slot = Slot;
+	Entry.Result = Result;
+	StoreEntry(Request, MoveTemp(Entry), Scope);
+}
+
+void FRequestCache::Invalidate(const FString& PubKey)
+{
+	TArray<FString> EntryKeys;
+	EntriesByAccount.MultiFind(PubKey, EntryKeys);
+	for( const FString& EntryKey : EntryKeys )
+	{
+		RemoveEntry(EntryKey);
+	}
+	Stats.Invalidations += EntryKeys.Num();
+}
+
+void FRequestCache::Invalidate(const FString& PubKey, uint64 Slot)
+{
+	uint64& MinSlot = MinSlotByAccount.FindOrAdd(PubKey);
+	MinSlot = FMath::Max(MinSlot, Slot);
+	Invalidate(PubKey);
+}
+
+void FRequestCache::Empty()
+{
+	Entries.Empty();
+	EntriesByAccount.Empty();
+	MinSlotByAccount.Empty();
+}
+
+const FRequestCacheStats& FRequestCache::GetStats()
+{
+	return Stats;
+}
@@ -20,92 +20,129 @@ Contributers: Daniele Calanna, Riccardo Torrisi
 
 #include "Network/RequestManager.h"
 
-#include "HttpModule.h"
-#include "Network/RequestUtils.h"
-#include "Interfaces/IHttpResponse.h"
-
-#include "FoundationSettings.h"
+#include "Network/SolanaRpcClient.h"
 
 DECLARE_LOG_CATEGORY_CLASS(RequestManager, Log, All);
 
-static int64 LastMessageID = 0;
-static TArray<FRequestData*> PendingRequests;
+static TSharedPtr<FSolanaRpcClient> DefaultClient;
 
-int64 FRequestManager::GetNextMessageID()
+static void AppendUtf8(TArray<uint8>& Out, const ANSICHAR* Ascii)
 {
-	return LastMessageID++;
+	Out.Append(reinterpret_cast<const uint8*>(Ascii), FCStringAnsi::Strlen(Ascii));
 }
 
-int64 FRequestManager::GetLastMessageID()
+// Transcode straight into Out, without an intermediate buffer.
+static void AppendUtf8(TArray<uint8>& Out, const FString& Text)
 {
-	return LastMessageID;
+	const int32 Length = FPlatformString::ConvertedLength<UTF8CHAR>(*Text, Text.Len());
+	const int32 Start = Out.AddUninitialized(Length);
+	FPlatformString::Convert(reinterpret_cast<UTF8CHAR*>(Out.GetData() + Start), Length, *Text, Text.Len());
 }
 
-void FRequestManager::SendRequest(FRequestData* RequestData)
+FRequestData::FRequestData(const FString& InMethod, const FString& InParams)
+	: Method(InMethod), Params(InParams)
 {
-	const FHttpRequestRef Request = FHttpModule::Get().CreateRequest();
-	FString Url = GetDefault<UFoundationSettings>()->GetNetworkURL();
-	if( Url.IsEmpty() )
-	{
-		Url = GetDefault<UFoundationSettings>()->GetNetwork() == ESolanaNetwork::DevNet ? "https://api.devnet.solana.com" : "https://api.mainnet-beta.solana.com";
-	}
-	Request->SetURL(Url);
-	Request->SetVerb("POST");
-	Request->SetHeader(TEXT("Content-Type"), TEXT("application/json"));
-	Request->SetContentAsString(RequestData->Body);
+}
 
-	Request->OnProcessRequestComplete().BindStatic(&FRequestManager::OnResponse);
-	Request->ProcessRequest();
+FString FRequestData::GetReadKey() const
+{
+	// Decoded and FJsonObject callers are kept apart, and decoded ones by result type, so a shared response always
+	// reaches callbacks of the kind it was made for.
+	return ResultTypeId ? FString::Printf(TEXT("%s%s#%p"), *Method, *Params, ResultTypeId) : Method + Params;
+}
 
-	PendingRequests.Push(RequestData);
+void FRequestData::EncodeBody()
+{
+	ANSICHAR IdText[16];
+	FCStringAnsi::Sprintf(IdText, "%u", Id);
+
+	Body.Reset();
+	Body.Reserve(48 + Method.Len() + Params.Len());
+	AppendUtf8(Body, R"({"jsonrpc":"2.0","id":)");
+	AppendUtf8(Body, IdText);
+	AppendUtf8(Body, R"(,"method":")");
+	AppendUtf8(Body, Method);
+	AppendUtf8(Body, R"(","params":)");
+	AppendUtf8(Body, Params);
+	Body.Add('}');
 }
 
-void FRequestManager::OnResponse(FHttpRequestPtr Request, FHttpResponsePtr Response, bool bSuccess)
+void FRequestManager::Startup()
 {
-	FString response = Response->GetContentAsString();
-	if (!bSuccess)
-	{
-		FRequestUtils::DisplayError("Http Request Failed");
-		return;
-	}
+#if !FOUNDATION_WITH_ZSTD
+	UE_LOG(RequestManager, Log, TEXT("Built without zstd (ThirdParty/zstd), base64+zstd account reads fall back to base64"));
+#endif
+	GetDefaultClient();
+}
 
-	TSharedPtr<FJsonObject> ParsedJSON;
-	TSharedRef<TJsonReader<TCHAR>> Reader = TJsonReaderFactory<>::Create(Response.Get()->GetContentAsString());
+void FRequestManager::Shutdown()
+{
+	DefaultClient.Reset();
+}
 
-	if (FJsonSerializer::Deserialize(Reader, ParsedJSON))
-	{
-		const TSharedPtr<FJsonObject>* outObject;
-		if(!ParsedJSON->TryGetObjectField("error", outObject))
-		{
-			int id = ParsedJSON->GetIntegerField("id");
-            if( PendingRequests.Num() > 0 )
-            {
-            	FRequestData* request = *PendingRequests.FindByPredicate([&](FRequestData* data){return data->Id == id;});
-            	if(request)
-            	{
-            		request->Callback.Execute(*ParsedJSON);
-            		PendingRequests.Remove(request);
-            		delete request;
-            	}
-            }
-		}
-		else
-		{
-			const TSharedPtr<FJsonObject> error = ParsedJSON->GetObjectField("error");
-			FRequestUtils::DisplayError(error->GetStringField("message"));
-		}
-	}
-	else
+TSharedRef<FSolanaRpcClient> FRequestManager::GetDefaultClient()
+{
+	// Created at module startup, so threads sending requests never race to create it.
+	if( !DefaultClient.IsValid() )
 	{
-		FRequestUtils::DisplayError("Failed to parse Response from the server");
+		DefaultClient = MakeShared<FSolanaRpcClient>();
 	}
+	return DefaultClient.ToSharedRef();
+}
+
+void FRequestManager::SendRequest(FRequestData* RequestData)
+{
+	GetDefaultClient()->SendRequest(RequestData);
 }
 
 void FRequestManager::CancelRequest(FRequestData* RequestData)
 {
-	if (RequestData)
-	{
-		RequestData->Callback.Unbind();
-		RequestData->ErrorCallback.Unbind();
-	}
+	GetDefaultClient()->CancelRequest(RequestData);
+}
+
+void FRequestManager::CancelRequest(uint32 Id)
+{
+	GetDefaultClient()->CancelRequest(Id);
+}
+
+const FRequestStats& FRequestManager::GetStats()
+{
+	return GetDefaultClient()->GetStats();
+}
+
+void FRequestManager::BeginBatch()
+{
+	GetDefaultClient()->BeginBatch();
+}
+
+void FRequestManager::FlushBatch()
+{
+	GetDefaultClient()->FlushBatch();
+}
+
+FRequestBatchScope::FRequestBatchScope()
+	: FRequestBatchScope(FRequestManager::GetDefaultClient())
+{
+}
+
+FRequestBatchScope::FRequestBatchScope(const TSharedRef<FSolanaRpcClient>& InClient)
+	: Client(InClient)
+{
+	Client->BeginBatch();
+}
+
+FRequestBatchScope::~FRequestBatchScope()
+{
+	Client->FlushBatch();
+}
+
+FRequestPriorityScope::FRequestPriorityScope(const TSharedRef<FSolanaRpcClient>& InClient, ERequestPriority Priority)
+	: Client(InClient)
+{
+	Client->PushPriority(Priority);
+}
+
+FRequestPriorityScope::~FRequestPriorityScope()
+{
+	Client->PopPriority();
 }
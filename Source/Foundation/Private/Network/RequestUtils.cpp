@@ -18,55 +18,304 @@ Author: Jon Sawler
 
 #include "Network/RequestUtils.h"
 
+#include "Crypto/Base58.h"
 #include "JsonObjectConverter.h"
+#include "Network/JsonStreamReader.h"
 #include "Network/RequestManager.h"
+#include "Network/SolanaRpcClient.h"
+#include "Misc/Base64.h"
 #include "Misc/MessageDialog.h"
+#include "SolanaUtils/Utils/TokenLayout.h"
+#include "SolanaUtils/Utils/TransactionUtils.h"
 #include "SolanaUtils/Utils/Types.h"
 
+#if FOUNDATION_WITH_ZSTD
+THIRD_PARTY_INCLUDES_START
+#include "zstd.h"
+THIRD_PARTY_INCLUDES_END
+#endif
+
 static FText ErrorTitle = FText::FromString("Error");
 static FText InfoTitle = FText::FromString("Info");
 
-FRequestData* FRequestUtils::RequestAccountInfo(const FString& pubKey)
+// Decimals never change once a mint exists, so they are kept for the whole session.
+static TMap<FString, uint8> MintDecimals;
+
+static FRequestData* WithAccountKeys(FRequestData* request, const TArray<FString>& accountKeys)
 {
-	FRequestData* request = new FRequestData(FRequestManager::GetNextMessageID());
+	request->AccountKeys = accountKeys;
+	return request;
+}
 
-	request->Body =
-		FString::Printf(TEXT(R"({"jsonrpc":"2.0","id":%u,"method":"getAccountInfo","params":["%s",{"encoding": "base58"}]})")
-		,request->Id, *pubKey );
+static bool DecodeTokenAmount(FJsonStreamReader& reader, FTokenUIBalanceJson& outData)
+{
+	return reader.ReadObject([&reader, &outData]()
+	{
+		if( reader.KeyEquals("amount") ) return reader.ReadString(outData.amount);
+		if( reader.KeyEquals("decimals") ) return reader.ReadNumber(outData.decimals);
+		if( reader.KeyEquals("uiAmount") ) return reader.ReadNumber(outData.uiAmount);
+		if( reader.KeyEquals("uiAmountString") ) return reader.ReadString(outData.uiAmountString);
+		return reader.SkipMemberValue();
+	});
+}
 
-	return request;
+static bool DecodeTokenInfo(FJsonStreamReader& reader, FTokenInfoJson& outData)
+{
+	return reader.ReadObject([&reader, &outData]()
+	{
+		if( reader.KeyEquals("tokenAmount") ) return reader.Next() != EJsonStreamToken::Error && DecodeTokenAmount(reader, outData.tokenAmount);
+		if( reader.KeyEquals("delegatedAmount") ) return reader.Next() != EJsonStreamToken::Error && DecodeTokenAmount(reader, outData.delegatedAmount);
+		if( reader.KeyEquals("delegate") ) return reader.ReadString(outData.delegate);
+		if( reader.KeyEquals("state") ) return reader.ReadString(outData.state);
+		if( reader.KeyEquals("isNative") ) return reader.ReadBool(outData.isNative);
+		if( reader.KeyEquals("mint") ) return reader.ReadString(outData.mint);
+		if( reader.KeyEquals("owner") ) return reader.ReadString(outData.owner);
+		return reader.SkipMemberValue();
+	});
 }
 
-FAccountInfoJson FRequestUtils::ParseAccountInfoResponse(const FJsonObject& data)
+static bool DecodeTokenData(FJsonStreamReader& reader, FTokenDataJson& outData)
 {
-	FAccountInfoJson jsonData;
-	if(TSharedPtr<FJsonObject> result = data.GetObjectField("result"))
+	// Accounts the node cannot parse come back as a [data, encoding] pair, which carries nothing for this struct.
+	if( reader.GetToken() == EJsonStreamToken::ArrayStart )
+	{
+		return reader.SkipValue();
+	}
+
+	return reader.ReadObject([&reader, &outData]()
+	{
+		if( reader.KeyEquals("program") ) return reader.ReadString(outData.program);
+		if( reader.KeyEquals("space") ) return reader.ReadNumber(outData.space);
+		if( reader.KeyEquals("parsed") )
+		{
+			reader.Next();
+			return reader.ReadObject([&reader, &outData]()
+			{
+				if( reader.KeyEquals("info") ) return reader.Next() != EJsonStreamToken::Error && DecodeTokenInfo(reader, outData.parsed.info);
+				if( reader.KeyEquals("type") || reader.KeyEquals("accountType") ) return reader.ReadString(outData.parsed.accountType);
+				if( reader.KeyEquals("space") ) return reader.ReadNumber(outData.parsed.space);
+				return reader.SkipMemberValue();
+			});
+		}
+		return reader.SkipMemberValue();
+	});
+}
+
+static bool DecodeTokenAccountData(FJsonStreamReader& reader, FTokenAccountDataJson& outData)
+{
+	return reader.ReadObject([&reader, &outData]()
+	{
+		if( reader.KeyEquals("data") ) return reader.Next() != EJsonStreamToken::Error && DecodeTokenData(reader, outData.data);
+		if( reader.KeyEquals("executable") ) return reader.ReadBool(outData.executable);
+		if( reader.KeyEquals("lamports") ) return reader.ReadNumber(outData.lamports);
+		if( reader.KeyEquals("owner") ) return reader.ReadString(outData.owner);
+		if( reader.KeyEquals("rentEpoch") ) return reader.ReadNumber(outData.rentEpoch);
+		return reader.SkipMemberValue();
+	});
+}
+
+static bool DecodeProgramAccount(FJsonStreamReader& reader, FProgramAccountJson& outData)
+{
+	return reader.ReadObject([&reader, &outData]()
+	{
+		if( reader.KeyEquals("data") )
+		{
+			// Binary data arrives as [data, encoding].
+			if( reader.Next() == EJsonStreamToken::ArrayStart )
+			{
+				bool bFirst = true;
+				return reader.ReadArray([&reader, &outData, &bFirst]()
+				{
+					if( bFirst )
+					{
+						outData.data = reader.GetString();
+						bFirst = false;
+					}
+					return reader.SkipValue();
+				});
+			}
+			outData.data = reader.GetString();
+			return reader.SkipValue();
+		}
+		if( reader.KeyEquals("executable") ) return reader.ReadBool(outData.executable);
+		if( reader.KeyEquals("lamports") ) return reader.ReadNumber(outData.lamports);
+		if( reader.KeyEquals("owner") ) return reader.ReadString(outData.owner);
+		if( reader.KeyEquals("rentEpoch") ) return reader.ReadNumber(outData.rentEpoch);
+		return reader.SkipMemberValue();
+	});
+}
+
+static bool DecodeAccountInfo(FJsonStreamReader& reader, FAccountInfoJson& account)
+{
+	return reader.ReadObject([&reader, &account]()
+	{
+		if( reader.KeyEquals("data") )
+		{
+			if( reader.Next() == EJsonStreamToken::ArrayStart )
+			{
+				return reader.ReadArray([&reader, &account]()
+				{
+					account.data.Add(reader.GetString());
+					return reader.SkipValue();
+				});
+			}
+			account.data.Add(reader.GetString());
+			return reader.SkipValue();
+		}
+		if( reader.KeyEquals("executable") ) return reader.ReadBool(account.executable);
+		if( reader.KeyEquals("lamports") ) return reader.ReadNumber(account.lamports);
+		if( reader.KeyEquals("owner") ) return reader.ReadString(account.owner);
+		if( reader.KeyEquals("rentEpoch") )
+		{
+			double rentEpoch;
+			const bool bRead = reader.ReadNumber(rentEpoch);
+			account.rentEpoch = static_cast<int32>(FMath::Min(rentEpoch, static_cast<double>(MAX_int32)));
+			return bRead;
+		}
+		return reader.SkipMemberValue();
+	});
+}
+
+// Read an account's binary "data" value, sent as [data, encoding], into raw bytes.
+static bool ReadAccountData(FJsonStreamReader& reader, TConstArrayView<uint8>& outBytes)
+{
+	if( reader.Next() != EJsonStreamToken::ArrayStart )
+	{
+		return false;
+	}
+
+	FString data;
+	FString encoding;
+	int32 index = 0;
+	const bool bRead = reader.ReadArray([&reader, &data, &encoding, &index]()
+	{
+		if( index == 0 ) data = reader.GetString();
+		else if( index == 1 ) encoding = reader.GetString();
+		index++;
+		return reader.SkipValue();
+	});
+
+	return bRead && FRequestUtils::DecodeAccountData(data, encoding, outBytes);
+}
+
+// Decode into outBytes, reusing its allocation.
+static bool DecodeBase64(const FString& data, TArray<uint8>& outBytes)
+{
+	const uint32 size = FBase64::GetDecodedDataSize(data);
+	outBytes.Reset();
+	outBytes.AddUninitialized(size);
+	return size == 0 || FBase64::Decode(*data, data.Len(), outBytes.GetData());
+}
+
+static bool DecodeAccountBytes(const FString& data, const FString& encoding, TArray<uint8>& outBytes)
+{
+	if( encoding == TEXT("base64") )
 	{
-		const TSharedPtr<FJsonObject> resultData = result->GetObjectField("value");
+		return DecodeBase64(data, outBytes);
+	}
+	if( encoding == TEXT("base58") )
+	{
+		outBytes = FBase58::DecodeBase58(data);
+		return outBytes.Num() > 0 || data.IsEmpty();
+	}
+#if FOUNDATION_WITH_ZSTD
+	if( encoding == TEXT("base64+zstd") )
+	{
+		static thread_local TArray<uint8> compressed;
+		if( !DecodeBase64(data, compressed) )
+		{
+			return false;
+		}
 
-		FString OutputString;
-		TSharedRef< TJsonWriter<> > Writer = TJsonWriterFactory<>::Create(&OutputString);
-		FJsonSerializer::Serialize(resultData.ToSharedRef(), Writer);
-		GEngine->AddOnScreenDebugMessage(-1, 10.f, FColor::Blue, OutputString);
+		const unsigned long long size = ZSTD_getFrameContentSize(compressed.GetData(), compressed.Num());
+		if( size == ZSTD_CONTENTSIZE_UNKNOWN || size == ZSTD_CONTENTSIZE_ERROR || size > MAX_int32 )
+		{
+			return false;
+		}
 
-		FJsonObjectConverter::JsonObjectToUStruct(resultData.ToSharedRef(), &jsonData);
+		outBytes.Reset();
+		outBytes.AddUninitialized(static_cast<int32>(size));
+		return !ZSTD_isError(ZSTD_decompress(outBytes.GetData(), size, compressed.GetData(), compressed.Num()));
+	}
+#endif
+	return false;
+}
 
-		FString Out = FString::Printf(TEXT("lamports: %f, owner: %s, rentEpoch: %i"), jsonData.lamports, *jsonData.owner, jsonData.rentEpoch);
-		GEngine->AddOnScreenDebugMessage(-1, 10.f, FColor::Blue, Out);
+bool FRequestUtils::DecodeAccountData(const FString& data, const FString& encoding, TConstArrayView<uint8>& outBytes)
+{
+	// Accounts are decoded, and frames decompressed, into per thread buffers that keep their capacity between accounts.
+	static thread_local TArray<uint8> decoded;
+	if( !DecodeAccountBytes(data, encoding, decoded) )
+	{
+		return false;
+	}
+	outBytes = decoded;
+	return true;
+}
 
+const TCHAR* FRequestUtils::GetEncodingName(EAccountEncoding encoding)
+{
+	switch( encoding )
+	{
+	case EAccountEncoding::Base58: return TEXT("base58");
+	case EAccountEncoding::Base64: return TEXT("base64");
+	case EAccountEncoding::Base64Zstd: return FOUNDATION_WITH_ZSTD ? TEXT("base64+zstd") : TEXT("base64");
+	default: return TEXT("jsonParsed");
+	}
+}
+
+// The config object of an account read.
+static FString AccountConfig(const TOptional<FDataSlice>& slice, EAccountEncoding encoding)
+{
+	FString config = FString::Printf(TEXT(R"({"encoding":"%s")"), FRequestUtils::GetEncodingName(encoding));
+	if( slice.IsSet() )
+	{
+		config += FString::Printf(TEXT(R"(,"dataSlice":{"offset":%llu,"length":%llu})"), slice->Offset, slice->Length);
+	}
+	config += TEXT("}");
+	return config;
+}
+
+FRequestData* FRequestUtils::RequestAccountInfo(const FString& pubKey, const TOptional<FDataSlice>& slice, EAccountEncoding encoding)
+{
+	return WithAccountKeys(new FRequestData(TEXT("getAccountInfo"),
+		FString::Printf(TEXT(R"(["%s",%s])"), *pubKey, *AccountConfig(slice, encoding) )), { pubKey });
+}
+
+FAccountInfoJson FRequestUtils::ParseAccountInfoResponse(const FJsonObject& data)
+{
+	FAccountInfoJson jsonData;
+	const TSharedPtr<FJsonObject>* result;
+	const TSharedPtr<FJsonObject>* value;
+	// A closed or never created account comes back as "value": null.
+	if( data.TryGetObjectField("result", result) && (*result)->TryGetObjectField("value", value) )
+	{
+		FJsonObjectConverter::JsonObjectToUStruct(value->ToSharedRef(), &jsonData);
 	}
 	return jsonData;
 }
 
+bool FRequestUtils::DecodeAccountInfoResult(FJsonStreamReader& reader, TOptional<FAccountInfoJson>& outData)
+{
+	return reader.ReadObject([&reader, &outData]()
+	{
+		if( !reader.KeyEquals("value") )
+		{
+			return reader.SkipMemberValue();
+		}
+
+		if( reader.Next() == EJsonStreamToken::Null )
+		{
+			return true;
+		}
+		return DecodeAccountInfo(reader, outData.Emplace());
+	});
+}
+
 FRequestData* FRequestUtils::RequestAccountBalance(const FString& pubKey)
 {
-	FRequestData* request = new FRequestData(FRequestManager::GetNextMessageID());
-	
-	request->Body =
-		FString::Printf(TEXT(R"({"jsonrpc":"2.0","id":%d,"method":"getBalance","params":["%s",{"commitment": "processed"}]})")
-			,request->Id , *pubKey );
-	
-	return request;
+	return WithAccountKeys(new FRequestData(TEXT("getBalance"),
+		FString::Printf(TEXT(R"(["%s",{"commitment": "processed"}])"), *pubKey )), { pubKey });
 }
 
 
@@ -83,38 +332,136 @@ double FRequestUtils::ParseAccountBalanceResponse(const FJsonObject& data)
 
 FRequestData* FRequestUtils::RequestTokenAccount(const FString& pubKey, const FString& mint)
 {
-	FRequestData* request = new FRequestData(FRequestManager::GetNextMessageID());
-	
-	request->Body =
-		FString::Printf(TEXT(R"({"jsonrpc":"2.0","id":%d,"method":"getTokenAccountsByOwner","params":["%s",{"mint": "%s"},{"encoding": "jsonParsed"}]})")
-			,request->Id, *pubKey, *mint );
-	
-	return request;
+	// Only the address of the account is read, so none of its data is downloaded.
+	return WithAccountKeys(new FRequestData(TEXT("getTokenAccountsByOwner"),
+		FString::Printf(TEXT(R"(["%s",{"mint": "%s"},{"encoding": "base64","dataSlice":{"offset":0,"length":0}}])"), *pubKey, *mint )), { pubKey });
 }
 
 FString FRequestUtils::ParseTokenAccountResponse(const FJsonObject& data)
 {
-	FTokenAccountArrayJson jsonData = ParseAllTokenAccountsResponse(data);
-
 	FString result;
-	if( !jsonData.value.IsEmpty() )
+	const TSharedPtr<FJsonObject>* resultObject;
+	const TArray<TSharedPtr<FJsonValue>>* value;
+	if( data.TryGetObjectField("result", resultObject) && (*resultObject)->TryGetArrayField("value", value) && value->Num() > 0 )
 	{
-		result = jsonData.value[0].pubkey;
+		(*value)[0]->AsObject()->TryGetStringField("pubkey", result);
 	}
 	return result;
 }
 
-FRequestData* FRequestUtils::RequestAllTokenAccounts(const FString& pubKey, const FString& programID)
+FRequestData* FRequestUtils::RequestAllTokenAccounts(const FString& pubKey, const FString& programID, EAccountEncoding encoding)
 {
-	FRequestData* request = new FRequestData(FRequestManager::GetNextMessageID());
-	
-	request->Body =
-		FString::Printf(TEXT(R"({"jsonrpc":"2.0","id":%d,"method":"getTokenAccountsByOwner","params":["%s",{"programId": "%s"},{"encoding": "jsonParsed"}]})")
-			,request->Id, *pubKey, *programID );
-	
+	FRequestData* request = WithAccountKeys(new FRequestData(TEXT("getTokenAccountsByOwner"),
+		FString::Printf(TEXT(R"(["%s",{"programId": "%s"},{"encoding": "%s"}])"), *pubKey, *programID, GetEncodingName(encoding) )), { pubKey });
+	request->bCompressResponse = true;
 	return request;
 }
 
+bool FRequestUtils::DecodeTokenAccountsResult(FJsonStreamReader& reader, TArray<FTokenAccountEntry>& outData)
+{
+	TConstArrayView<uint8> bytes;
+	return reader.ReadObject([&reader, &outData, &bytes]()
+	{
+		if( !reader.KeyEquals("value") )
+		{
+			return reader.SkipMemberValue();
+		}
+
+		reader.Next();
+		return reader.ReadArray([&reader, &outData, &bytes]()
+		{
+			FTokenAccountEntry entry;
+			bool bDecoded = false;
+			const bool bRead = reader.ReadObject([&reader, &entry, &bytes, &bDecoded]()
+			{
+				if( reader.KeyEquals("pubkey") ) return reader.ReadString(entry.Pubkey);
+				if( reader.KeyEquals("account") )
+				{
+					reader.Next();
+					return reader.ReadObject([&reader, &entry, &bytes, &bDecoded]()
+					{
+						if( reader.KeyEquals("data") )
+						{
+							bDecoded = ReadAccountData(reader, bytes) && FTokenAccountLayout::Decode(bytes.GetData(), bytes.Num(), entry.Account);
+							return !reader.HasError();
+						}
+						return reader.SkipMemberValue();
+					});
+				}
+				return reader.SkipMemberValue();
+			});
+
+			// Accounts that are not in the token layout are left out rather than failing the whole list.
+			if( bDecoded )
+			{
+				outData.Add(MoveTemp(entry));
+			}
+			return bRead;
+		});
+	});
+}
+
+bool FRequestUtils::ParseTokenAccountData(const FJsonObject& account, FTokenAccountLayout& outAccount)
+{
+	const TArray<TSharedPtr<FJsonValue>>* data;
+	TConstArrayView<uint8> bytes;
+	return account.TryGetArrayField("data", data) && data->Num() >= 2
+		&& DecodeAccountData((*data)[0]->AsString(), (*data)[1]->AsString(), bytes)
+		&& FTokenAccountLayout::Decode(bytes.GetData(), bytes.Num(), outAccount);
+}
+
+void FRequestUtils::FetchMintDecimals(const TArray<FString>& mints, TFunction<void(const TMap<FString, uint8>&)> callback, const TSharedPtr<FSolanaRpcClient>& client)
+{
+	TArray<FString> unknownMints;
+	for( const FString& mint : mints )
+	{
+		if( !MintDecimals.Contains(mint) )
+		{
+			unknownMints.AddUnique(mint);
+		}
+	}
+
+	auto complete = [mints, callback]()
+	{
+		TMap<FString, uint8> decimals;
+		for( const FString& mint : mints )
+		{
+			if( const uint8* mintDecimals = MintDecimals.Find(mint) )
+			{
+				decimals.Add(mint, *mintDecimals);
+			}
+		}
+		callback(decimals);
+	};
+
+	if( unknownMints.Num() == 0 )
+	{
+		complete();
+		return;
+	}
+
+	// Only the decimals byte of each mint is downloaded.
+	FetchMultipleAccounts(unknownMints, FDataSlice{ MintDecimalsOffset, 1 }, EAccountEncoding::Base64, [complete](const TMap<FString, FAccountInfoJson>& accounts)
+	{
+		for( const TPair<FString, FAccountInfoJson>& account : accounts )
+		{
+			TConstArrayView<uint8> bytes;
+			uint8 decimals;
+			if( account.Value.data.Num() >= 2 && DecodeAccountData(account.Value.data[0], account.Value.data[1], bytes)
+				&& FTokenAccountLayout::DecodeMintDecimals(bytes.GetData(), bytes.Num(), true, decimals) )
+			{
+				MintDecimals.Add(account.Key, decimals);
+			}
+		}
+		complete();
+	},
+	[complete](const FText& failureReason)
+	{
+		// Hand back whatever is already known; the missing mints are simply left out.
+		complete();
+	}, client);
+}
+
 FTokenAccountArrayJson FRequestUtils::ParseAllTokenAccountsResponse(const FJsonObject& data)
 {
 	FTokenAccountArrayJson jsonData;
@@ -125,58 +472,301 @@ FTokenAccountArrayJson FRequestUtils::ParseAllTokenAccountsResponse(const FJsonO
 	return jsonData;
 }
 
+bool FRequestUtils::DecodeAllTokenAccountsResult(FJsonStreamReader& reader, FTokenAccountArrayJson& outData)
+{
+	return reader.ReadObject([&reader, &outData]()
+	{
+		if( !reader.KeyEquals("value") )
+		{
+			return reader.SkipMemberValue();
+		}
+
+		reader.Next();
+		return reader.ReadArray([&reader, &outData]()
+		{
+			FTokenBalanceDataJson& entry = outData.value.AddDefaulted_GetRef();
+			return reader.ReadObject([&reader, &entry]()
+			{
+				if( reader.KeyEquals("pubkey") ) return reader.ReadString(entry.pubkey);
+				if( reader.KeyEquals("account") ) return reader.Next() != EJsonStreamToken::Error && DecodeTokenAccountData(reader, entry.account);
+				return reader.SkipMemberValue();
+			});
+		});
+	});
+}
+
+FProgramAccountsQuery& FProgramAccountsQuery::DataSize(uint64 Size)
+{
+	Filters.Add(FString::Printf(TEXT(R"({"dataSize":%llu})"), Size));
+	return *this;
+}
+
+FProgramAccountsQuery& FProgramAccountsQuery::Memcmp(uint64 Offset, const FString& Bytes, EMemcmpEncoding Encoding)
+{
+	Filters.Add(FString::Printf(TEXT(R"({"memcmp":{"offset":%llu,"bytes":"%s","encoding":"%s"}})"),
+		Offset, *Bytes, Encoding == EMemcmpEncoding::Base64 ? TEXT("base64") : TEXT("base58")));
+	return *this;
+}
+
+FProgramAccountsQuery& FProgramAccountsQuery::Memcmp(uint64 Offset, const TArray<uint8>& Bytes)
+{
+	// Base64 is cheaper to produce than base58 and the node accepts either.
+	return Memcmp(Offset, FBase64::Encode(Bytes), EMemcmpEncoding::Base64);
+}
+
+FProgramAccountsQuery& FProgramAccountsQuery::DataSlice(uint64 Offset, uint64 Length)
+{
+	Slice = FString::Printf(TEXT(R"({"offset":%llu,"length":%llu})"), Offset, Length);
+	return *this;
+}
+
+FProgramAccountsQuery& FProgramAccountsQuery::Commitment(const FString& InCommitment)
+{
+	CommitmentLevel = InCommitment;
+	return *this;
+}
+
+FProgramAccountsQuery& FProgramAccountsQuery::Encoding(EAccountEncoding InEncoding)
+{
+	AccountEncoding = InEncoding;
+	return *this;
+}
+
+FString FProgramAccountsQuery::ToParams() const
+{
+	FString config = FString::Printf(TEXT(R"({"encoding":"%s")"), FRequestUtils::GetEncodingName(AccountEncoding));
+	if( Filters.Num() > 0 )
+	{
+		config += FString::Printf(TEXT(R"(,"filters":[%s])"), *FString::Join(Filters, TEXT(",")));
+	}
+	if( !Slice.IsEmpty() )
+	{
+		config += FString::Printf(TEXT(R"(,"dataSlice":%s)"), *Slice);
+	}
+	if( !CommitmentLevel.IsEmpty() )
+	{
+		config += FString::Printf(TEXT(R"(,"commitment":"%s")"), *CommitmentLevel);
+	}
+	config.AppendChar(TEXT('}'));
+
+	return FString::Printf(TEXT(R"(["%s",%s])"), *ProgramId, *config);
+}
+
 FRequestData* FRequestUtils::RequestProgramAccounts(const FString& programID, const UINT& size, const FString& pubKey)
 {
-	FRequestData* request = new FRequestData(FRequestManager::GetNextMessageID());
-	
-	request->Body =
-		FString::Printf(TEXT(R"({"jsonrpc":"2.0","id":%d,"method":"getProgramAccounts","params":["%s",{"encoding":"base64","filters":[{"dataSize":%d},{"memcmp":{"offset":8,"bytes":"%s"}}]}]})")
-			,request->Id, *programID, size,*pubKey );
-		
+	return RequestProgramAccounts(FProgramAccountsQuery(programID).DataSize(size).Memcmp(8, pubKey));
+}
+
+FRequestData* FRequestUtils::RequestProgramAccounts(const FProgramAccountsQuery& query)
+{
+	FRequestData* request = new FRequestData(TEXT("getProgramAccounts"), query.ToParams());
+	request->bCompressResponse = true;
 	return request;
 }
 
 TArray<FProgramAccountJson> FRequestUtils::ParseProgramAccountsResponse(const FJsonObject& data)
 {
 	TArray<FProgramAccountJson> list;
-	TArray<TSharedPtr<FJsonValue>> dataArray = data.GetArrayField("result");
-	for(const TSharedPtr<FJsonValue> entry:  dataArray )
+	const TArray<TSharedPtr<FJsonValue>>* dataArray;
+	if( !data.TryGetArrayField("result", dataArray) )
+	{
+		return list;
+	}
+
+	list.Reserve(dataArray->Num());
+	for( const TSharedPtr<FJsonValue>& entry : *dataArray )
 	{
-		const TSharedPtr<FJsonObject> entryObject = entry->AsObject();
-		if( TSharedPtr<FJsonObject> account = entryObject->GetObjectField("account") )
+		const TSharedPtr<FJsonObject>* entryObject;
+		const TSharedPtr<FJsonObject>* account;
+		if( !entry->TryGetObject(entryObject) || !(*entryObject)->TryGetObjectField("account", account) )
+		{
+			continue;
+		}
+
+		// Read field by field: binary data arrives as [data, encoding], which the converter cannot put in a string.
+		FProgramAccountJson& accountData = list.AddDefaulted_GetRef();
+		(*entryObject)->TryGetStringField("pubkey", accountData.pubkey);
+		(*account)->TryGetBoolField("executable", accountData.executable);
+		(*account)->TryGetNumberField("lamports", accountData.lamports);
+		(*account)->TryGetStringField("owner", accountData.owner);
+		(*account)->TryGetNumberField("rentEpoch", accountData.rentEpoch);
+
+		const TArray<TSharedPtr<FJsonValue>>* dataPair;
+		if( (*account)->TryGetArrayField("data", dataPair) && dataPair->Num() > 0 )
 		{
-			FProgramAccountJson accountData;
-			FJsonObjectConverter::JsonObjectToUStruct( account.ToSharedRef() , &accountData);
-			list.Add(accountData);
+			accountData.data = (*dataPair)[0]->AsString();
+		}
+		else
+		{
+			(*account)->TryGetStringField("data", accountData.data);
 		}
-		FString pubKey = entryObject->GetStringField("pubkey");
 	}
-	
 	return list;
 }
 
-FRequestData* FRequestUtils::RequestMultipleAccounts(const TArray<FString>& pubKey)
+bool FRequestUtils::DecodeProgramAccountsResult(FJsonStreamReader& reader, TArray<FProgramAccountJson>& outData)
 {
-	FRequestData* request = new FRequestData(FRequestManager::GetNextMessageID());
-	
-	FString list;
-	for( FString key: pubKey )
+	return reader.ReadArray([&reader, &outData]()
 	{
-		list.Append(FString::Printf(TEXT(R"("%s")"),*key));
+		FProgramAccountJson& entry = outData.AddDefaulted_GetRef();
+		return reader.ReadObject([&reader, &entry]()
+		{
+			if( reader.KeyEquals("account") ) return reader.Next() != EJsonStreamToken::Error && DecodeProgramAccount(reader, entry);
+			if( reader.KeyEquals("pubkey") ) return reader.ReadString(entry.pubkey);
+			return reader.SkipMemberValue();
+		});
+	});
+}
+
+void FRequestUtils::FetchProgramAccounts(const FProgramAccountsQuery& query, TFunction<void(const TArray<FProgramAccountJson>&)> callback, TFunction<void(const FText&)> errorCallback, const TSharedPtr<FSolanaRpcClient>& client)
+{
+	const TSharedRef<FSolanaRpcClient> rpcClient = client.IsValid() ? client.ToSharedRef() : FRequestManager::GetDefaultClient();
 
-		if(key != pubKey.Last())
+	FRequestData* request = RequestProgramAccounts(query);
+	request->BindResult<TArray<FProgramAccountJson>>(&FRequestUtils::DecodeProgramAccountsResult, MoveTemp(callback));
+	request->ErrorCallback.BindLambda([errorCallback = MoveTemp(errorCallback)](const FText& failureReason)
+	{
+		if( errorCallback )
+		{
+			errorCallback(failureReason);
+		}
+		else
+		{
+			DisplayError(failureReason.ToString());
+		}
+	});
+	rpcClient->SendRequest(request);
+}
+
+FRequestData* FRequestUtils::RequestMultipleAccounts(const TArray<FString>& pubKey, const TOptional<FDataSlice>& slice, EAccountEncoding encoding)
+{
+	FString list;
+	list.Reserve(pubKey.Num() * (Base58PubKeySize + 3));
+	for( int32 index = 0; index < pubKey.Num(); index++ )
+	{
+		if( index != 0 )
 		{
-			list.Append(",");
+			list.AppendChar(TEXT(','));
 		}
+		list.AppendChar(TEXT('"'));
+		list.Append(pubKey[index]);
+		list.AppendChar(TEXT('"'));
 	}
 		
-	request->Body =
-		FString::Printf(TEXT(R"({"jsonrpc":"2.0","id":%d,"method": "getMultipleAccounts","params":[[%s],{"dataSlice":{"offset":0,"length":0}}]})")
-			,request->Id , *list );
-	
+	FRequestData* request = WithAccountKeys(new FRequestData(TEXT("getMultipleAccounts"),
+		FString::Printf(TEXT(R"([[%s],%s])"), *list, *AccountConfig(slice, encoding) )), pubKey);
+	request->bCompressResponse = true;
 	return request;
 }
 
+bool FRequestUtils::DecodeMultipleAccountsResult(FJsonStreamReader& reader, TArray<TOptional<FAccountInfoJson>>& outData)
+{
+	return reader.ReadObject([&reader, &outData]()
+	{
+		if( !reader.KeyEquals("value") )
+		{
+			return reader.SkipMemberValue();
+		}
+
+		reader.Next();
+		return reader.ReadArray([&reader, &outData]()
+		{
+			// Accounts that do not exist come back as null.
+			TOptional<FAccountInfoJson>& entry = outData.AddDefaulted_GetRef();
+			if( reader.GetToken() == EJsonStreamToken::Null )
+			{
+				return true;
+			}
+
+			return DecodeAccountInfo(reader, entry.Emplace());
+		});
+	});
+}
+
+void FRequestUtils::FetchMultipleAccounts(const TArray<FString>& pubKeys, TFunction<void(const TMap<FString, FAccountInfoJson>&)> callback, TFunction<void(const FText&)> errorCallback, const TSharedPtr<FSolanaRpcClient>& client)
+{
+	FetchMultipleAccounts(pubKeys, FDataSlice(), EAccountEncoding::Base64, MoveTemp(callback), MoveTemp(errorCallback), client);
+}
+
+void FRequestUtils::FetchMultipleAccounts(const TArray<FString>& pubKeys, const TOptional<FDataSlice>& slice, EAccountEncoding encoding, TFunction<void(const TMap<FString, FAccountInfoJson>&)> callback, TFunction<void(const FText&)> errorCallback, const TSharedPtr<FSolanaRpcClient>& client)
+{
+	const TSharedRef<FSolanaRpcClient> rpcClient = client.IsValid() ? client.ToSharedRef() : FRequestManager::GetDefaultClient();
+
+	struct FMultipleAccountsFetch
+	{
+		TArray<FString> Keys;
+		TArray<TOptional<FAccountInfoJson>> Accounts;
+		int32 RemainingChunks = 0;
+		bool bFailed = false;
+		TFunction<void(const TMap<FString, FAccountInfoJson>&)> Callback;
+		TFunction<void(const FText&)> ErrorCallback;
+	};
+
+	if( pubKeys.Num() == 0 )
+	{
+		callback(TMap<FString, FAccountInfoJson>());
+		return;
+	}
+
+	const TSharedRef<FMultipleAccountsFetch> fetch = MakeShared<FMultipleAccountsFetch>();
+	fetch->Keys = pubKeys;
+	fetch->Accounts.SetNum(pubKeys.Num());
+	fetch->RemainingChunks = FMath::DivideAndRoundUp(pubKeys.Num(), MaxMultipleAccountsKeys);
+	fetch->Callback = MoveTemp(callback);
+	fetch->ErrorCallback = MoveTemp(errorCallback);
+
+	// Every chunk is in flight at once. Results are written back by position and merged once the last one lands.
+	for( int32 first = 0; first < pubKeys.Num(); first += MaxMultipleAccountsKeys )
+	{
+		const int32 count = FMath::Min(MaxMultipleAccountsKeys, pubKeys.Num() - first);
+		FRequestData* request = RequestMultipleAccounts(TArray<FString>(pubKeys.GetData() + first, count), slice, encoding);
+
+		request->BindResult<TArray<TOptional<FAccountInfoJson>>>(&FRequestUtils::DecodeMultipleAccountsResult, [fetch, first, count](const TArray<TOptional<FAccountInfoJson>>& chunk)
+		{
+			for( int32 index = 0; index < count && index < chunk.Num(); index++ )
+			{
+				fetch->Accounts[first + index] = chunk[index];
+			}
+
+			if( --fetch->RemainingChunks > 0 || fetch->bFailed )
+			{
+				return;
+			}
+
+			TMap<FString, FAccountInfoJson> accounts;
+			accounts.Reserve(fetch->Keys.Num());
+			for( int32 index = 0; index < fetch->Keys.Num(); index++ )
+			{
+				if( fetch->Accounts[index].IsSet() )
+				{
+					accounts.Add(fetch->Keys[index], fetch->Accounts[index].GetValue());
+				}
+			}
+			fetch->Callback(accounts);
+		});
+
+		request->ErrorCallback.BindLambda([fetch](const FText& failureReason)
+		{
+			if( fetch->bFailed )
+			{
+				return;
+			}
+			fetch->bFailed = true;
+
+			if( fetch->ErrorCallback )
+			{
+				fetch->ErrorCallback(failureReason);
+			}
+			else
+			{
+				DisplayError(failureReason.ToString());
+			}
+		});
+
+		rpcClient->SendRequest(request);
+	}
+}
+
 TArray<FAccountInfoJson> FRequestUtils::ParseMultipleAccountsResponse(const FJsonObject& data)
 {
 	TArray<FAccountInfoJson> jsonData;
@@ -187,14 +777,24 @@ TArray<FAccountInfoJson> FRequestUtils::ParseMultipleAccountsResponse(const FJso
 	return jsonData;
 }
 
-FRequestData* FRequestUtils::SendTransaction(const FString& transaction)
+FRequestData* FRequestUtils::SendTransaction(const FString& transaction, bool skipPreflight, int32 maxRetries)
 {
-	FRequestData* request = new FRequestData(FRequestManager::GetNextMessageID());
-	
-	request->Body =
-		FString::Printf(TEXT(R"({"jsonrpc":"2.0","id":%d,"method":"sendTransaction","params":["%s",{"encoding": "base64"}]})")
-			,request->Id, *transaction );
-	
+	TArray<uint8> transactionData;
+	FBase64::Decode(transaction, transactionData);
+
+	FString config = TEXT(R"("encoding": "base64")");
+	if( skipPreflight )
+	{
+		config += TEXT(R"(,"skipPreflight":true)");
+	}
+	if( maxRetries >= 0 )
+	{
+		config += FString::Printf(TEXT(R"(,"maxRetries":%d)"), maxRetries);
+	}
+
+	FRequestData* request = WithAccountKeys(new FRequestData(TEXT("sendTransaction"),
+		FString::Printf(TEXT(R"(["%s",{%s}])"), *transaction, *config)), FTransactionUtils::GetAccountKeys(transactionData));
+	request->Priority = ERequestPriority::Transaction;
 	return request;
 }
 
@@ -203,15 +803,81 @@ FString FRequestUtils::ParseTransactionResponse(const FJsonObject& data)
 	return data.GetStringField("result");
 }
 
+FRequestData* FRequestUtils::RequestSignatureStatuses(const TArray<FString>& signatures)
+{
+	check(signatures.Num() <= MaxSignatureStatuses);
+
+	FString list;
+	list.Reserve(signatures.Num() * (Base58PrKeySize + 3));
+	for( int32 index = 0; index < signatures.Num(); index++ )
+	{
+		if( index != 0 )
+		{
+			list.AppendChar(TEXT(','));
+		}
+		list.AppendChar(TEXT('"'));
+		list.Append(signatures[index]);
+		list.AppendChar(TEXT('"'));
+	}
+
+	return new FRequestData(TEXT("getSignatureStatuses"), FString::Printf(TEXT(R"([[%s],{"searchTransactionHistory":false}])"), *list));
+}
+
+TArray<ETransactionStatus> FRequestUtils::ParseSignatureStatusesResponse(const FJsonObject& data)
+{
+	TArray<ETransactionStatus> statuses;
+
+	const TSharedPtr<FJsonObject>* result;
+	const TArray<TSharedPtr<FJsonValue>>* values;
+	if( !data.TryGetObjectField("result", result) || !(*result)->TryGetArrayField("value", values) )
+	{
+		return statuses;
+	}
+
+	statuses.Reserve(values->Num());
+	for( const TSharedPtr<FJsonValue>& value : *values )
+	{
+		const TSharedPtr<FJsonObject>* status;
+		if( !value.IsValid() || !value->TryGetObject(status) )
+		{
+			statuses.Add(ETransactionStatus::Pending);
+			continue;
+		}
+
+		const TSharedPtr<FJsonValue> error = (*status)->TryGetField("err");
+		if( error.IsValid() && !error->IsNull() )
+		{
+			statuses.Add(ETransactionStatus::Failed);
+			continue;
+		}
+
+		// Nodes predating confirmationStatus report rooted transactions with null confirmations.
+		FString confirmationStatus;
+		if( !(*status)->TryGetStringField("confirmationStatus", confirmationStatus) )
+		{
+			const TSharedPtr<FJsonValue> confirmations = (*status)->TryGetField("confirmations");
+			confirmationStatus = confirmations.IsValid() && confirmations->IsNull() ? TEXT("finalized") : TEXT("processed");
+		}
+
+		if( confirmationStatus == TEXT("finalized") )
+		{
+			statuses.Add(ETransactionStatus::Finalized);
+		}
+		else if( confirmationStatus == TEXT("confirmed") )
+		{
+			statuses.Add(ETransactionStatus::Confirmed);
+		}
+		else
+		{
+			statuses.Add(ETransactionStatus::Processed);
+		}
+	}
+	return statuses;
+}
+
 FRequestData* FRequestUtils::RequestBlockHash()
 {
-	FRequestData* request = new FRequestData(FRequestManager::GetNextMessageID());
-	
-	request->Body =
-		FString::Printf(TEXT(R"({"id":%d,"jsonrpc":"2.0","method":"getRecentBlockhash","params":[{"commitment":"processed"}]})")
-				,request->Id );
-	
-	return request;
+	return new FRequestData(TEXT("getLatestBlockhash"), TEXT(R"([{"commitment":"processed"}])"));
 }
 
 FString FRequestUtils::ParseBlockHashResponse(const FJsonObject& data)
@@ -225,15 +891,32 @@ FString FRequestUtils::ParseBlockHashResponse(const FJsonObject& data)
 	return hash;
 }
 
+FLatestBlockhashJson FRequestUtils::ParseLatestBlockHashResponse(const FJsonObject& data)
+{
+	FLatestBlockhashJson jsonData;
+	if(TSharedPtr<FJsonObject> result = data.GetObjectField("result"))
+	{
+		FJsonObjectConverter::JsonObjectToUStruct(result.ToSharedRef(), &jsonData);
+	}
+	return jsonData;
+}
+
+FRequestData* FRequestUtils::RequestBlockHeight()
+{
+	return new FRequestData(TEXT("getBlockHeight"), TEXT(R"([{"commitment":"confirmed"}])"));
+}
+
+uint64 FRequestUtils::ParseBlockHeightResponse(const FJsonObject& data)
+{
+	int64 height = 0;
+	data.TryGetNumberField("result", height);
+	return static_cast<uint64>(height);
+}
+
 FRequestData* FRequestUtils::GetTransactionFeeAmount(const FString& transaction)
 {
-	FRequestData* request = new FRequestData(FRequestManager::GetNextMessageID());
-	
-	request->Body =
-		FString::Printf(TEXT(R"({"jsonrpc":"2.0","id":%d,"method":"getFeeForMessage", "params":[%s,{"commitment":"processed"}]})")
-			,request->Id, *transaction );
-	
-	return request;
+	return new FRequestData(TEXT("getFeeForMessage"),
+		FString::Printf(TEXT(R"([%s,{"commitment":"processed"}])"), *transaction ));
 }
 
 int FRequestUtils::ParseTransactionFeeAmountResponse(const FJsonObject& data)
@@ -249,13 +932,8 @@ int FRequestUtils::ParseTransactionFeeAmountResponse(const FJsonObject& data)
 
 FRequestData* FRequestUtils::RequestAirDrop(const FString& pubKey)
 {
-	FRequestData* request = new FRequestData(FRequestManager::GetNextMessageID());
-	
-	request->Body =
-		FString::Printf(TEXT(R"({"jsonrpc":"2.0","id":%d, "method":"requestAirdrop", "params":["%s", 1000000000]})")
-				,request->Id, *pubKey );
-	
-	return request;
+	return new FRequestData(TEXT("requestAirdrop"),
+		FString::Printf(TEXT(R"(["%s", 1000000000])"), *pubKey ));
 }
 
 void FRequestUtils::DisplayError(const FString& error)
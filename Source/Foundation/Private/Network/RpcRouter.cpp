@@ -0,0 +1,197 @@
+/*
+Copyright 2022 ATMTA, Inc.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+	http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+*/
+#include "Network/RpcRouter.h"
+
+#include "FoundationSettings.h"
+
+DECLARE_LOG_CATEGORY_CLASS(RpcRouter, Log, All);
+
+// Weight of the newest sample in the smoothed latency and error rate.
+constexpr double SmoothingFactor = 0.2;
+
+constexpr int32 FailuresToTrip = 3;
+constexpr double TripErrorRate = 0.5;
+constexpr int32 MinRequestsForErrorRate = 10;
+constexpr double BaseCooldown = 5.0;
+constexpr double MaxCooldown = 120.0;
+
+// Added to the request timeout before a probe with no outcome is written off, so the timeout sweep reports first.
+constexpr double ProbeTimeoutGrace = 5.0;
+
+// Stands in for the latency of an endpoint that has not answered yet, so each one gets tried early.
+constexpr double UnmeasuredLatency = 0.0;
+
+// Every endpoint seen so far. Health belongs to the URL, so it carries over when the network changes.
+static TArray<FRpcEndpointStats> Endpoints;
+
+FRpcEndpointStats* FRpcRouter::FindEndpoint(const FString& URL)
+{
+	return Endpoints.FindByPredicate([&URL](const FRpcEndpointStats& Endpoint){ return Endpoint.URL == URL; });
+}
+
+FRpcEndpointStats& FRpcRouter::FindOrAddEndpoint(const FString& URL)
+{
+	if( FRpcEndpointStats* Endpoint = FindEndpoint(URL) )
+	{
+		return *Endpoint;
+	}
+	FRpcEndpointStats& Endpoint = Endpoints.AddDefaulted_GetRef();
+	Endpoint.URL = URL;
+	return Endpoint;
+}
+
+double FRpcRouter::GetScore(const FRpcEndpointStats& Endpoint)
+{
+	const double Latency = Endpoint.Requests > Endpoint.Failures ? Endpoint.Latency : UnmeasuredLatency;
+	return Latency * (1.0 + 4.0 * Endpoint.ErrorRate) + Endpoint.ErrorRate;
+}
+
+FString FRpcRouter::SelectEndpoint()
+{
+	return SelectEndpoint(GetDefault<UFoundationSettings>()->GetNetworkURLs());
+}
+
+FString FRpcRouter::SelectEndpoint(const TArray<FString>& URLs)
+{
+	if( URLs.Num() == 0 )
+	{
+		return FString();
+	}
+
+	// Added up front, so the pointers below stay valid.
+	for( const FString& URL : URLs )
+	{
+		FindOrAddEndpoint(URL);
+	}
+
+	const double Now = FPlatformTime::Seconds();
+	const double ProbeTimeout = GetDefault<UFoundationSettings>()->GetRequestTimeout() + ProbeTimeoutGrace;
+	FRpcEndpointStats* Best = nullptr;
+	FRpcEndpointStats* SoonestOpen = nullptr;
+	for( const FString& URL : URLs )
+	{
+		FRpcEndpointStats& Endpoint = *FindEndpoint(URL);
+		if( Endpoint.IsOpen(Now) )
+		{
+			if( !SoonestOpen || Endpoint.OpenUntil < SoonestOpen->OpenUntil )
+			{
+				SoonestOpen = &Endpoint;
+			}
+			continue;
+		}
+
+		if( Endpoint.bProbing && Now - Endpoint.ProbeStartTime > ProbeTimeout )
+		{
+			UE_LOG(RpcRouter, Log, TEXT("Probe of %s never completed"), *Endpoint.URL);
+			Endpoint.bProbing = false;
+		}
+
+		if( Endpoint.Trips > 0 && !Endpoint.bProbing )
+		{
+			// Cooldown is over: let one request through to see whether the endpoint recovered.
+			Endpoint.bProbing = true;
+			Endpoint.ProbeStartTime = Now;
+			UE_LOG(RpcRouter, Log, TEXT("Probing %s"), *Endpoint.URL);
+			return Endpoint.URL;
+		}
+
+		if( Endpoint.bProbing )
+		{
+			continue;
+		}
+
+		if( !Best || GetScore(Endpoint) < GetScore(*Best) )
+		{
+			Best = &Endpoint;
+		}
+	}
+
+	if( Best )
+	{
+		return Best->URL;
+	}
+
+	// Every endpoint is ejected or being probed. Sending somewhere beats failing the request outright.
+	if( SoonestOpen )
+	{
+		return SoonestOpen->URL;
+	}
+	return URLs[0];
+}
+
+void FRpcRouter::ReportSuccess(const FString& URL, double Latency)
+{
+	FRpcEndpointStats* Endpoint = FindEndpoint(URL);
+	if( !Endpoint )
+	{
+		return;
+	}
+
+	Endpoint->Latency = Endpoint->Requests > Endpoint->Failures ? FMath::Lerp(Endpoint->Latency, Latency, SmoothingFactor) : Latency;
+	Endpoint->ErrorRate = FMath::Lerp(Endpoint->ErrorRate, 0.0, SmoothingFactor);
+	Endpoint->Requests++;
+	Endpoint->ConsecutiveFailures = 0;
+
+	if( Endpoint->bProbing || Endpoint->Trips > 0 )
+	{
+		UE_LOG(RpcRouter, Log, TEXT("%s recovered"), *URL);
+		Endpoint->bProbing = false;
+		Endpoint->Trips = 0;
+		Endpoint->OpenUntil = 0.0;
+	}
+}
+
+void FRpcRouter::ReportFailure(const FString& URL, double Latency)
+{
+	FRpcEndpointStats* Endpoint = FindEndpoint(URL);
+	if( !Endpoint )
+	{
+		return;
+	}
+
+	Endpoint->ErrorRate = FMath::Lerp(Endpoint->ErrorRate, 1.0, SmoothingFactor);
+	Endpoint->Requests++;
+	Endpoint->Failures++;
+	Endpoint->ConsecutiveFailures++;
+
+	const bool bTrip = Endpoint->bProbing
+		|| Endpoint->ConsecutiveFailures >= FailuresToTrip
+		|| (Endpoint->Requests >= MinRequestsForErrorRate && Endpoint->ErrorRate >= TripErrorRate);
+	if( bTrip && !Endpoint->IsOpen(FPlatformTime::Seconds()) )
+	{
+		const double Cooldown = FMath::Min(BaseCooldown * FMath::Pow(2.0, Endpoint->Trips), MaxCooldown);
+		Endpoint->OpenUntil = FPlatformTime::Seconds() + Cooldown;
+		Endpoint->Trips++;
+		Endpoint->bProbing = false;
+		UE_LOG(RpcRouter, Warning, TEXT("Ejecting %s for %.0f seconds"), *URL, Cooldown);
+	}
+}
+
+TArray<FRpcEndpointStats> FRpcRouter::GetEndpoints()
+{
+	TArray<FRpcEndpointStats> NetworkEndpoints;
+	for( const FString& URL : GetDefault<UFoundationSettings>()->GetNetworkURLs() )
+	{
+		NetworkEndpoints.Add(FindOrAddEndpoint(URL));
+	}
+	return NetworkEndpoints;
+}
+
+void FRpcRouter::Reset()
+{
+	Endpoints.Empty();
+}
@@ -0,0 +1,1070 @@
+/*
+Copyright 2022 ATMTA, Inc.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+	http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+*/
+
+#include "Network/SolanaRpcClient.h"
+
+#include "HttpModule.h"
+#include "Async/Async.h"
+#include "Containers/Ticker.h"
+#include "Misc/Compression.h"
+#include "Network/RequestUtils.h"
+#include "Interfaces/IHttpResponse.h"
+#include "Network/JsonStreamReader.h"
+#include "Network/RateLimiter.h"
+#include "Network/RequestCache.h"
+#include "Network/RpcRouter.h"
+
+#include "FoundationSettings.h"
+
+DECLARE_LOG_CATEGORY_CLASS(SolanaRpcClient, Log, All);
+
+constexpr float TimeoutSweepInterval = 1.f;
+constexpr double RetryBaseDelay = 0.5;
+constexpr double RetryMaxDelay = 10.0;
+
+// Gzipped responses claiming to inflate past this, or past this many times their compressed size, are rejected
+// rather than allocated. JSON-RPC responses stay well under the ratio, a forged size trailer does not.
+constexpr uint32 MaxInflatedSize = 256 * 1024 * 1024;
+constexpr uint32 MaxCompressionRatio = 64;
+
+// Inflate buffers a worker keeps between responses. A larger one is released once its response is decoded.
+constexpr int32 MaxRetainedInflateBuffer = 4 * 1024 * 1024;
+
+// Reads can be collapsed with identical reads in flight and are safe to send again.
+static bool IsIdempotent(const FString& Method)
+{
+	return !Method.IsEmpty() && Method != TEXT("sendTransaction") && Method != TEXT("requestAirdrop");
+}
+
+struct FResponseEntry
+{
+	int32 Start = 0;
+	int32 End = 0;
+	int64 Id = -1;
+};
+
+static float GetRequestTimeout(const FRequestData& Request)
+{
+	return Request.Timeout > 0.f ? Request.Timeout : GetDefault<UFoundationSettings>()->GetRequestTimeout();
+}
+
+// Find where each response in a body starts and ends and which request it answers, without decoding anything else.
+static bool SplitResponseEntries(const TArray<uint8>& Content, TArray<FResponseEntry>& OutEntries)
+{
+	FJsonStreamReader Reader(Content.GetData(), Content.Num());
+	auto ReadEntry = [&Reader, &OutEntries]()
+	{
+		FResponseEntry& Entry = OutEntries.AddDefaulted_GetRef();
+		Entry.Start = Reader.GetTokenStart();
+		const bool bRead = Reader.ReadObject([&Reader, &Entry]()
+		{
+			if( Reader.KeyEquals("id") )
+			{
+				if( Reader.Next() == EJsonStreamToken::Number )
+				{
+					Entry.Id = static_cast<int64>(Reader.GetUInt64());
+				}
+				return Reader.SkipValue();
+			}
+			return Reader.SkipMemberValue();
+		});
+		Entry.End = Reader.GetOffset();
+		return bRead;
+	};
+
+	switch( Reader.Next() )
+	{
+	case EJsonStreamToken::ObjectStart:
+		return ReadEntry();
+	case EJsonStreamToken::ArrayStart:
+		return Reader.ReadArray(ReadEntry);
+	default:
+		return false;
+	}
+}
+
+// Decoder of a request that binds a result. Its duplicates share the read key, and so the result type.
+struct FDecodeJob
+{
+	uint32 Id = 0;
+	TFunction<TSharedPtr<const FRequestResult>(FJsonStreamReader&)> Decoder;
+};
+
+struct FDecodedEntry
+{
+	int64 Id = -1;
+
+	// Set for callers that want a FJsonObject. Requests with a bound result were decoded in place instead.
+	TSharedPtr<FJsonObject> Object;
+
+	bool bError = false;
+	FString ErrorMessage;
+
+	// What the matching FDecodeJob decoded, null if it failed, and the slot of the result's context.
+	TSharedPtr<const FRequestResult> Result;
+	uint64 Slot = 0;
+};
+
+struct FDecodedResponse
+{
+	TArray<uint32> Ids;
+	FString URL;
+	float ElapsedTime = 0.f;
+	bool bParsed = false;
+	bool bCompressed = false;
+	int32 BytesReceived = 0;
+	int32 BytesDecoded = 0;
+	TArray<FDecodedEntry> Entries;
+};
+
+// Game thread time spent per frame running completed responses.
+constexpr double CompletionBudget = 0.002;
+
+static void DecodeResultEntry(const uint8* Data, int32 Size, const FDecodeJob& Job, FDecodedEntry& OutEntry)
+{
+	FJsonStreamReader Reader(Data, Size);
+	Reader.Next();
+
+	int32 ResultStart = INDEX_NONE;
+	Reader.ReadObject([&]()
+	{
+		if( Reader.KeyEquals("result") )
+		{
+			Reader.Next();
+			ResultStart = Reader.GetTokenStart();
+			return false;
+		}
+		if( Reader.KeyEquals("error") )
+		{
+			OutEntry.bError = true;
+			Reader.Next();
+			return Reader.ReadObject([&Reader, &OutEntry]()
+			{
+				return Reader.KeyEquals("message") ? Reader.ReadString(OutEntry.ErrorMessage) : Reader.SkipMemberValue();
+			});
+		}
+		return Reader.SkipMemberValue();
+	});
+
+	if( OutEntry.bError || ResultStart == INDEX_NONE )
+	{
+		return;
+	}
+
+	// RPC nodes write the context first, so only the leading member is looked at.
+	FJsonStreamReader ContextReader(Data + ResultStart, Size - ResultStart);
+	ContextReader.Next();
+	ContextReader.ReadObject([&ContextReader, &OutEntry]()
+	{
+		if( ContextReader.KeyEquals("context") )
+		{
+			ContextReader.Next();
+			ContextReader.ReadObject([&ContextReader, &OutEntry]()
+			{
+				if( ContextReader.KeyEquals("slot") )
+				{
+					ContextReader.Next();
+					OutEntry.Slot = ContextReader.GetUInt64();
+					return false;
+				}
+				return ContextReader.SkipMemberValue();
+			});
+		}
+		return false;
+	});
+
+	FJsonStreamReader ResultReader(Data + ResultStart, Size - ResultStart);
+	ResultReader.Next();
+	OutEntry.Result = Job.Decoder(ResultReader);
+}
+
+// Runs on a worker thread. Touches nothing but the response bytes, the jobs and the output.
+static void DecodeResponse(const TArray<uint8>& Content, const TArray<FDecodeJob>& Jobs, FDecodedResponse& OutResponse)
+{
+	TArray<FResponseEntry> Entries;
+	OutResponse.bParsed = SplitResponseEntries(Content, Entries);
+	if( !OutResponse.bParsed )
+	{
+		return;
+	}
+
+	for( const FResponseEntry& Entry : Entries )
+	{
+		FDecodedEntry& Decoded = OutResponse.Entries.AddDefaulted_GetRef();
+		Decoded.Id = Entry.Id;
+
+		const uint8* Data = Content.GetData() + Entry.Start;
+		const int32 Size = Entry.End - Entry.Start;
+		if( const FDecodeJob* Job = Jobs.FindByPredicate([&Entry](const FDecodeJob& Candidate){ return Candidate.Id == Entry.Id; }) )
+		{
+			DecodeResultEntry(Data, Size, *Job, Decoded);
+			continue;
+		}
+
+		// Only the entries of callers that want a FJsonObject are turned into one.
+		// Transcoded once, straight into the string the reader takes over.
+		FString EntryText;
+		TArray<TCHAR>& EntryChars = EntryText.GetCharArray();
+		const int32 Length = FPlatformString::ConvertedLength<TCHAR>(reinterpret_cast<const UTF8CHAR*>(Data), Size);
+		EntryChars.AddUninitialized(Length + 1);
+		FPlatformString::Convert(EntryChars.GetData(), Length, reinterpret_cast<const UTF8CHAR*>(Data), Size);
+		EntryChars[Length] = TEXT('\0');
+
+		TSharedRef<TJsonReader<TCHAR>> Reader = TJsonReaderFactory<>::Create(MoveTemp(EntryText));
+		FJsonSerializer::Deserialize(Reader, Decoded.Object);
+	}
+}
+
+static bool IsGzip(const TArray<uint8>& Content)
+{
+	return Content.Num() >= 18 && Content[0] == 0x1f && Content[1] == 0x8b;
+}
+
+// Some HTTP backends inflate on their own, so this only runs on bodies that still carry the gzip header.
+static bool InflateGzip(const TArray<uint8>& Compressed, TArray<uint8>& OutInflated)
+{
+	// ISIZE, the last four bytes of a gzip member, is the inflated size. It comes from the server and only holds modulo
+	// 2^32 for the last member, so it is bounded by the compressed size before anything is allocated, and a body
+	// that does not inflate to exactly that size fails below.
+	const uint8* Trailer = Compressed.GetData() + Compressed.Num() - 4;
+	const uint32 Size = Trailer[0] | (Trailer[1] << 8) | (Trailer[2] << 16) | (static_cast<uint32>(Trailer[3]) << 24);
+	if( Size > MaxInflatedSize || Size > static_cast<uint64>(Compressed.Num()) * MaxCompressionRatio )
+	{
+		return false;
+	}
+
+	OutInflated.Reset();
+	OutInflated.AddUninitialized(Size);
+	return FCompression::UncompressMemory(NAME_Gzip, OutInflated.GetData(), Size, Compressed.GetData(), Compressed.Num());
+}
+
+TUniquePtr<FRequestData> FSolanaRpcClient::TakePendingRequest(uint32 Id)
+{
+	TUniquePtr<FRequestData> Request;
+	if( TUniquePtr<FRequestData>* Found = PendingRequests.Find(Id) )
+	{
+		Request = MoveTemp(*Found);
+		PendingRequests.Remove(Id);
+
+		const FString ReadKey = Request->GetReadKey();
+		if( InFlightReads.FindRef(ReadKey) == Id )
+		{
+			InFlightReads.Remove(ReadKey);
+		}
+	}
+	return Request;
+}
+
+FSolanaRpcClient::FSolanaRpcClient(const TArray<FString>& InEndpoints)
+	: Endpoints(InEndpoints), CacheScope(FString::Join(InEndpoints, TEXT(" ")))
+{
+}
+
+FSolanaRpcClient::~FSolanaRpcClient()
+{
+	for( FTSTicker::FDelegateHandle* Handle : { &FlushTimerHandle, &TimeoutTimerHandle, &PumpTimerHandle, &CompletionTimerHandle } )
+	{
+		if( Handle->IsValid() )
+		{
+			FTSTicker::GetCoreTicker().RemoveTicker(*Handle);
+		}
+	}
+
+	// Decodes still running hold a reference to the client, so by now every decoded response is in the queue.
+	FDecodedResponse* Decoded;
+	while( DecodedResponses.Dequeue(Decoded) )
+	{
+		delete Decoded;
+	}
+
+	FRequestData* RequestData;
+	while( Submissions.Dequeue(RequestData) )
+	{
+		delete RequestData;
+	}
+}
+
+TArray<FString> FSolanaRpcClient::GetEndpoints() const
+{
+	return Endpoints.Num() > 0 ? Endpoints : GetDefault<UFoundationSettings>()->GetNetworkURLs();
+}
+
+void FSolanaRpcClient::SendRequest(FRequestData* RequestData)
+{
+	if( !RequestData )
+	{
+		return;
+	}
+
+	RequestData->Id = NextId.fetch_add(1, std::memory_order_relaxed);
+	RequestData->EncodeBody();
+
+	if( IsInGameThread() )
+	{
+		AcceptRequest(RequestData);
+		return;
+	}
+
+	Submissions.Enqueue(RequestData);
+	if( !bSubmissionTickPending.exchange(true) )
+	{
+		FTSTicker::GetCoreTicker().AddTicker(FTickerDelegate::CreateSP(this, &FSolanaRpcClient::OnSubmissionTick));
+	}
+}
+
+bool FSolanaRpcClient::OnSubmissionTick(float DeltaTime)
+{
+	// Cleared first so a request enqueued while draining schedules another tick.
+	bSubmissionTickPending = false;
+
+	FRequestData* RequestData;
+	while( Submissions.Dequeue(RequestData) )
+	{
+		AcceptRequest(RequestData);
+	}
+	return false;
+}
+
+void FSolanaRpcClient::AcceptRequest(FRequestData* RequestData)
+{
+	Stats.Requests++;
+
+	if( RequestData->Method == TEXT("sendTransaction") )
+	{
+		for( const FString& PubKey : RequestData->AccountKeys )
+		{
+			FRequestCache::Invalidate(PubKey);
+		}
+	}
+	else if( RequestData->ResultDecoder )
+	{
+		if( const TSharedPtr<const FRequestResult> CachedResult = FRequestCache::FindResult(*RequestData, CacheScope) )
+		{
+			const TUniquePtr<FRequestData> Request(RequestData);
+			Request->ResultCallback(*CachedResult);
+			return;
+		}
+	}
+	else if( const TSharedPtr<FJsonObject> CachedResponse = FRequestCache::Find(*RequestData, CacheScope) )
+	{
+		const TUniquePtr<FRequestData> Request(RequestData);
+		Request->Callback.ExecuteIfBound(*CachedResponse);
+		return;
+	}
+
+	if( IsIdempotent(RequestData->Method) )
+	{
+		const FString ReadKey = RequestData->GetReadKey();
+		if( const uint32* InFlightId = InFlightReads.Find(ReadKey) )
+		{
+			Stats.Collapsed++;
+			PendingRequests[*InFlightId]->Duplicates.Emplace(RequestData);
+			return;
+		}
+		InFlightReads.Add(ReadKey, RequestData->Id);
+	}
+
+	RequestData->ExpireTime = FPlatformTime::Seconds() + GetRequestTimeout(*RequestData);
+
+	if( PriorityScopes.Num() > 0 && RequestData->Priority == ERequestPriority::Interactive )
+	{
+		RequestData->Priority = PriorityScopes.Last();
+	}
+	const ERequestPriority Priority = RequestData->Priority;
+
+	QueuedRequests.Push(RequestData->Id);
+	PendingRequests.Add(RequestData->Id, TUniquePtr<FRequestData>(RequestData));
+
+	if( !TimeoutTimerHandle.IsValid() )
+	{
+		TimeoutTimerHandle = FTSTicker::GetCoreTicker().AddTicker(FTickerDelegate::CreateSP(this, &FSolanaRpcClient::OnTimeoutSweep), TimeoutSweepInterval);
+	}
+
+	// Transactions do not wait out the batching latency.
+	const int32 MaxBatchSize = GetDefault<UFoundationSettings>()->GetMaxBatchSize();
+	if( QueuedRequests.Num() >= MaxBatchSize || (Priority == ERequestPriority::Transaction && BatchScopeDepth == 0) )
+	{
+		FlushQueuedRequests();
+	}
+	else if( BatchScopeDepth == 0 )
+	{
+		ScheduleFlush();
+	}
+}
+
+void FSolanaRpcClient::BeginBatch()
+{
+	BatchScopeDepth++;
+}
+
+void FSolanaRpcClient::FlushBatch()
+{
+	if( BatchScopeDepth > 0 )
+	{
+		BatchScopeDepth--;
+	}
+
+	if( BatchScopeDepth == 0 )
+	{
+		FlushQueuedRequests();
+	}
+}
+
+void FSolanaRpcClient::PushPriority(ERequestPriority Priority)
+{
+	PriorityScopes.Push(Priority);
+}
+
+void FSolanaRpcClient::PopPriority()
+{
+	if( PriorityScopes.Num() > 0 )
+	{
+		PriorityScopes.Pop();
+	}
+}
+
+void FSolanaRpcClient::ScheduleFlush()
+{
+	if( !FlushTimerHandle.IsValid() )
+	{
+		const float Latency = GetDefault<UFoundationSettings>()->GetBatchFlushLatency();
+		FlushTimerHandle = FTSTicker::GetCoreTicker().AddTicker(FTickerDelegate::CreateSP(this, &FSolanaRpcClient::OnFlushTimer), Latency);
+	}
+}
+
+bool FSolanaRpcClient::OnFlushTimer(float DeltaTime)
+{
+	FlushTimerHandle.Reset();
+	if( BatchScopeDepth == 0 )
+	{
+		FlushQueuedRequests();
+	}
+	return false;
+}
+
+void FSolanaRpcClient::FlushQueuedRequests()
+{
+	if( FlushTimerHandle.IsValid() )
+	{
+		FTSTicker::GetCoreTicker().RemoveTicker(FlushTimerHandle);
+		FlushTimerHandle.Reset();
+	}
+
+	// Requests that timed out while queued are no longer in the pending table.
+	QueuedRequests.RemoveAll([this](uint32 Id){ return !PendingRequests.Contains(Id); });
+
+	// Each priority is batched apart, so a transaction never rides in a batch of background reads.
+	const int32 MaxBatchSize = GetDefault<UFoundationSettings>()->GetMaxBatchSize();
+	for( const ERequestPriority Priority : { ERequestPriority::Transaction, ERequestPriority::Interactive, ERequestPriority::Background } )
+	{
+		FOutboundBatch Batch;
+		Batch.Priority = Priority;
+		for( const uint32 Id : QueuedRequests )
+		{
+			if( PendingRequests[Id]->Priority != Priority )
+			{
+				continue;
+			}
+
+			Batch.Ids.Add(Id);
+			if( Batch.Ids.Num() == MaxBatchSize )
+			{
+				EnqueueBatch(MoveTemp(Batch));
+				Batch = FOutboundBatch();
+				Batch.Priority = Priority;
+			}
+		}
+
+		if( Batch.Ids.Num() > 0 )
+		{
+			EnqueueBatch(MoveTemp(Batch));
+		}
+	}
+	QueuedRequests.Reset();
+
+	PumpSendQueue();
+}
+
+void FSolanaRpcClient::EnqueueBatch(FOutboundBatch&& Batch)
+{
+	// After every batch of the same or a higher priority.
+	int32 Index = SendQueue.Num();
+	while( Index > 0 && SendQueue[Index - 1].Priority > Batch.Priority )
+	{
+		Index--;
+	}
+	SendQueue.Insert(MoveTemp(Batch), Index);
+}
+
+void FSolanaRpcClient::PumpSendQueue()
+{
+	if( PumpTimerHandle.IsValid() )
+	{
+		FTSTicker::GetCoreTicker().RemoveTicker(PumpTimerHandle);
+		PumpTimerHandle.Reset();
+	}
+
+	const double Now = FPlatformTime::Seconds();
+	const int32 MaxInFlight = GetDefault<UFoundationSettings>()->GetMaxInFlightRequests();
+	double NextAttempt = TNumericLimits<double>::Max();
+
+	for( int32 Index = 0; Index < SendQueue.Num() && InFlightPosts.Num() < MaxInFlight; )
+	{
+		FOutboundBatch& Batch = SendQueue[Index];
+
+		// Requests that timed out or were cancelled while waiting are no longer in the pending table.
+		Batch.Ids.RemoveAll([this](uint32 Id){ return !PendingRequests.Contains(Id); });
+		if( Batch.Ids.Num() == 0 )
+		{
+			SendQueue.RemoveAt(Index);
+			continue;
+		}
+
+		// Everything from here on is background, which always leaves a slot for a transaction or an interactive read.
+		if( Batch.Priority == ERequestPriority::Background && MaxInFlight > 1 && InFlightPosts.Num() >= MaxInFlight - 1 )
+		{
+			break;
+		}
+
+		if( Batch.NotBefore > Now )
+		{
+			NextAttempt = FMath::Min(NextAttempt, Batch.NotBefore);
+			Index++;
+			continue;
+		}
+
+		const FString Url = FRpcRouter::SelectEndpoint(GetEndpoints());
+		if( !FRateLimiter::TryAcquire(Url) )
+		{
+			NextAttempt = FMath::Min(NextAttempt, Now + FRateLimiter::GetWaitTime(Url));
+			break;
+		}
+
+		const TArray<uint32> Ids = MoveTemp(Batch.Ids);
+		SendQueue.RemoveAt(Index);
+		PostRequestBody(Url, Ids);
+	}
+
+	// A full in-flight window is pumped again by the next response.
+	if( SendQueue.Num() > 0 && NextAttempt != TNumericLimits<double>::Max() )
+	{
+		PumpTimerHandle = FTSTicker::GetCoreTicker().AddTicker(FTickerDelegate::CreateSP(this, &FSolanaRpcClient::OnPumpTimer), FMath::Max(NextAttempt - Now, 0.0));
+	}
+}
+
+bool FSolanaRpcClient::OnPumpTimer(float DeltaTime)
+{
+	PumpTimerHandle.Reset();
+	PumpSendQueue();
+	return false;
+}
+
+void FSolanaRpcClient::PostRequestBody(const FString& Url, const TArray<uint32>& Ids)
+{
+	const FHttpRequestRef Request = FHttpModule::Get().CreateRequest();
+	if( Ids.Num() == 1 )
+	{
+		Request->SetContent(PendingRequests[Ids[0]]->Body);
+	}
+	else
+	{
+		// Batches are assembled in one buffer that keeps its capacity from post to post.
+		BatchBody.Reset();
+		BatchBody.Add('[');
+		for( int32 Index = 0; Index < Ids.Num(); Index++ )
+		{
+			if( Index != 0 )
+			{
+				BatchBody.Add(',');
+			}
+			BatchBody.Append(PendingRequests[Ids[Index]]->Body);
+		}
+		BatchBody.Add(']');
+		Request->SetContent(BatchBody);
+
+		UE_LOG(SolanaRpcClient, Verbose, TEXT("Sending batch of %d requests"), Ids.Num());
+	}
+
+	for( const uint32 Id : Ids )
+	{
+		PendingRequests[Id]->Endpoint = Url;
+	}
+
+	Request->SetURL(Url);
+	Request->SetVerb("POST");
+	Request->SetHeader(TEXT("Content-Type"), TEXT("application/json; charset=utf-8"));
+
+	if( GetDefault<UFoundationSettings>()->GetCompressResponses()
+		&& Ids.ContainsByPredicate([this](uint32 Id){ return PendingRequests[Id]->bCompressResponse; }) )
+	{
+		Request->SetHeader(TEXT("Accept-Encoding"), TEXT("gzip"));
+	}
+
+	Request->OnProcessRequestComplete().BindSP(this, &FSolanaRpcClient::OnResponse, Ids);
+	Request->ProcessRequest();
+
+	InFlightPosts.Add({ Request, Ids });
+	Stats.HttpRequests++;
+}
+
+void FSolanaRpcClient::RetryRequests(const TArray<uint32>& Ids, double RetryAfter, const FText& FailureReason)
+{
+	const int32 MaxRetries = GetDefault<UFoundationSettings>()->GetMaxRequestRetries();
+
+	FOutboundBatch Retry;
+	Retry.Priority = ERequestPriority::Background;
+	TArray<uint32> FailedIds;
+	int32 Retries = 0;
+	for( const uint32 Id : Ids )
+	{
+		if( const TUniquePtr<FRequestData>* Request = PendingRequests.Find(Id) )
+		{
+			if( IsIdempotent((*Request)->Method) && (*Request)->Retries < MaxRetries )
+			{
+				Retries = FMath::Max(Retries, ++(*Request)->Retries);
+				Retry.Ids.Add(Id);
+				Retry.Priority = FMath::Min(Retry.Priority, (*Request)->Priority);
+			}
+			else
+			{
+				FailedIds.Add(Id);
+			}
+		}
+	}
+
+	if( FailedIds.Num() > 0 )
+	{
+		FailRequests(FailedIds, FailureReason);
+	}
+
+	if( Retry.Ids.Num() > 0 )
+	{
+		// Jitter keeps many clients throttled at the same moment from coming back in lockstep.
+		const double Delay = RetryAfter > 0.0
+			? RetryAfter
+			: FMath::Min(RetryBaseDelay * FMath::Pow(2.0, Retries - 1), RetryMaxDelay) * FMath::FRandRange(0.5, 1.5);
+		Retry.NotBefore = FPlatformTime::Seconds() + Delay;
+
+		// Each attempt gets its full timeout from when it is posted, or the sweep would fail it while it waits out the delay.
+		for( const uint32 Id : Retry.Ids )
+		{
+			FRequestData& Request = *PendingRequests[Id];
+			Request.ExpireTime = FMath::Max(Request.ExpireTime, Retry.NotBefore + GetRequestTimeout(Request));
+		}
+
+		UE_LOG(SolanaRpcClient, Log, TEXT("Retrying %d requests in %.2f seconds"), Retry.Ids.Num(), Delay);
+		Stats.Retried += Retry.Ids.Num();
+		EnqueueBatch(MoveTemp(Retry));
+	}
+}
+
+bool FSolanaRpcClient::OnTimeoutSweep(float DeltaTime)
+{
+	const double Now = FPlatformTime::Seconds();
+
+	TArray<uint32> ExpiredIds;
+	TSet<FString> ExpiredEndpoints;
+	for( const TPair<uint32, TUniquePtr<FRequestData>>& Entry : PendingRequests )
+	{
+		if( Entry.Value->ExpireTime <= Now )
+		{
+			ExpiredIds.Add(Entry.Key);
+			if( !Entry.Value->Endpoint.IsEmpty() )
+			{
+				ExpiredEndpoints.Add(Entry.Value->Endpoint);
+			}
+		}
+	}
+
+	for( const FString& Endpoint : ExpiredEndpoints )
+	{
+		FRpcRouter::ReportFailure(Endpoint, GetDefault<UFoundationSettings>()->GetRequestTimeout());
+	}
+
+	if( ExpiredIds.Num() > 0 )
+	{
+		UE_LOG(SolanaRpcClient, Warning, TEXT("%d requests timed out"), ExpiredIds.Num());
+		Stats.TimedOut += ExpiredIds.Num();
+		FailRequests(ExpiredIds, FText::FromString("Request timed out"));
+		AbortOrphanedPosts();
+	}
+
+	if( PendingRequests.Num() == 0 )
+	{
+		TimeoutTimerHandle.Reset();
+		return false;
+	}
+	return true;
+}
+
+void FSolanaRpcClient::FailRequests(const TArray<uint32>& Ids, const FText& FailureReason)
+{
+	bool bUnhandled = false;
+	for( const uint32 Id : Ids )
+	{
+		if( const TUniquePtr<FRequestData> Request = TakePendingRequest(Id) )
+		{
+			// Cancelled requests are gone as far as their sender knows, so they neither fail nor show an error.
+			auto Fail = [this, &FailureReason, &bUnhandled](FRequestData& Failed)
+			{
+				if( Failed.bCancelled )
+				{
+					return;
+				}
+
+				Stats.Failed++;
+				if( Failed.ErrorCallback.IsBound() )
+				{
+					Failed.ErrorCallback.Execute(FailureReason);
+				}
+				else
+				{
+					bUnhandled = true;
+				}
+			};
+
+			Fail(*Request);
+			for( const TUniquePtr<FRequestData>& Duplicate : Request->Duplicates )
+			{
+				Fail(*Duplicate);
+			}
+		}
+	}
+
+	if( bUnhandled )
+	{
+		FRequestUtils::DisplayError(FailureReason.ToString());
+	}
+}
+
+void FSolanaRpcClient::OnResponse(FHttpRequestPtr Request, FHttpResponsePtr Response, bool bSuccess, TArray<uint32> Ids)
+{
+	// Aborted posts already gave their slot back and have nobody left to answer.
+	const int32 PostIndex = InFlightPosts.IndexOfByPredicate([&Request](const FInFlightPost& Post){ return Post.Request == Request; });
+	if( PostIndex == INDEX_NONE )
+	{
+		return;
+	}
+	InFlightPosts.RemoveAtSwap(PostIndex);
+
+	const int32 ResponseCode = Response.IsValid() ? Response->GetResponseCode() : 0;
+	if (!bSuccess || !Response.IsValid() || ResponseCode == EHttpResponseCodes::TooManyRequests || ResponseCode >= EHttpResponseCodes::ServerError)
+	{
+		double RetryAfter = 0.0;
+		if( ResponseCode == EHttpResponseCodes::TooManyRequests )
+		{
+			const FString RetryAfterHeader = Response->GetHeader(TEXT("Retry-After"));
+			if( RetryAfterHeader.IsNumeric() )
+			{
+				RetryAfter = FCString::Atod(*RetryAfterHeader);
+			}
+			FRateLimiter::OnThrottled(Request->GetURL(), RetryAfter);
+			Stats.Throttled++;
+		}
+
+		FRpcRouter::ReportFailure(Request->GetURL(), Request->GetElapsedTime());
+		RetryRequests(Ids, RetryAfter, FText::FromString("Http Request Failed"));
+		PumpSendQueue();
+		return;
+	}
+
+	TArray<FDecodeJob> Jobs;
+	for( const uint32 Id : Ids )
+	{
+		if( const TUniquePtr<FRequestData>* Pending = PendingRequests.Find(Id) )
+		{
+			// Identical reads sent from now on start a new request, so the duplicates decoded below are final.
+			const FString ReadKey = (*Pending)->GetReadKey();
+			if( InFlightReads.FindRef(ReadKey) == Id )
+			{
+				InFlightReads.Remove(ReadKey);
+			}
+
+			if( (*Pending)->ResultDecoder )
+			{
+				FDecodeJob& Job = Jobs.AddDefaulted_GetRef();
+				Job.Id = Id;
+				Job.Decoder = (*Pending)->ResultDecoder;
+			}
+		}
+	}
+
+	FDecodedResponse* Decoded = new FDecodedResponse();
+	Decoded->Ids = MoveTemp(Ids);
+	Decoded->URL = Request->GetURL();
+	Decoded->ElapsedTime = Request->GetElapsedTime();
+
+	DecodesInFlight++;
+	if( !CompletionTimerHandle.IsValid() )
+	{
+		CompletionTimerHandle = FTSTicker::GetCoreTicker().AddTicker(FTickerDelegate::CreateSP(this, &FSolanaRpcClient::OnCompletionTick));
+	}
+
+	auto Decode = [Client = AsShared(), Response, Jobs = MoveTemp(Jobs), Decoded]()
+	{
+		// Each worker keeps its inflate buffer, up to MaxRetainedInflateBuffer, so typical responses reuse it.
+		static thread_local TArray<uint8> Inflated;
+
+		const TArray<uint8>& Content = Response->GetContent();
+		Decoded->BytesReceived = Content.Num();
+		Decoded->bCompressed = IsGzip(Content) && InflateGzip(Content, Inflated);
+
+		const TArray<uint8>& Body = Decoded->bCompressed ? Inflated : Content;
+		Decoded->BytesDecoded = Body.Num();
+		DecodeResponse(Body, Jobs, *Decoded);
+		if( Inflated.Max() > MaxRetainedInflateBuffer )
+		{
+			Inflated.Empty();
+		}
+		Client->DecodedResponses.Enqueue(Decoded);
+	};
+
+	if( FPlatformProcess::SupportsMultithreading() )
+	{
+		Async(EAsyncExecution::ThreadPool, MoveTemp(Decode));
+	}
+	else
+	{
+		Decode();
+	}
+
+	PumpSendQueue();
+}
+
+bool FSolanaRpcClient::OnCompletionTick(float DeltaTime)
+{
+	// Responses left over when the budget runs out wait for the next frame.
+	const double Deadline = FPlatformTime::Seconds() + CompletionBudget;
+	FDecodedResponse* Decoded;
+	while( FPlatformTime::Seconds() < Deadline && DecodedResponses.Dequeue(Decoded) )
+	{
+		DecodesInFlight--;
+		CompleteDecodedResponse(*TUniquePtr<FDecodedResponse>(Decoded));
+	}
+
+	if( DecodesInFlight == 0 )
+	{
+		CompletionTimerHandle.Reset();
+		return false;
+	}
+	return true;
+}
+
+void FSolanaRpcClient::CompleteDecodedResponse(FDecodedResponse& Decoded)
+{
+	Stats.BytesReceived += Decoded.BytesReceived;
+	Stats.BytesDecoded += Decoded.BytesDecoded;
+	if( Decoded.bCompressed )
+	{
+		Stats.CompressedResponses++;
+	}
+
+	if( Decoded.bParsed )
+	{
+		FRpcRouter::ReportSuccess(Decoded.URL, Decoded.ElapsedTime);
+		FRateLimiter::OnSuccess(Decoded.URL);
+	}
+	else
+	{
+		FRpcRouter::ReportFailure(Decoded.URL, Decoded.ElapsedTime);
+	}
+
+	for( const FDecodedEntry& Entry : Decoded.Entries )
+	{
+		if( Entry.Object.IsValid() )
+		{
+			DispatchResponse(Entry.Object);
+		}
+		else if( Entry.Id >= 0 )
+		{
+			CompleteDecodedResult(Entry);
+		}
+	}
+
+	// Anything in this request that got no matching response entry is failed here so its entry is released.
+	Decoded.Ids.RemoveAll([this](uint32 Id){ return !PendingRequests.Contains(Id); });
+	if( Decoded.Ids.Num() > 0 )
+	{
+		FailRequests(Decoded.Ids, FText::FromString("Failed to parse Response from the server"));
+	}
+}
+
+void FSolanaRpcClient::DispatchResponse(const TSharedPtr<FJsonObject>& ParsedJSON)
+{
+	int64 id = -1;
+	if( !ParsedJSON->TryGetNumberField("id", id) )
+	{
+		const TSharedPtr<FJsonObject>* error;
+		if( ParsedJSON->TryGetObjectField("error", error) )
+		{
+			FRequestUtils::DisplayError((*error)->GetStringField("message"));
+		}
+		return;
+	}
+
+	const TSharedPtr<FJsonObject>* error;
+	if( ParsedJSON->TryGetObjectField("error", error) )
+	{
+		FailRequests({ static_cast<uint32>(id) }, FText::FromString((*error)->GetStringField("message")));
+		return;
+	}
+
+	if( const TUniquePtr<FRequestData> request = TakePendingRequest(static_cast<uint32>(id)) )
+	{
+		CompleteRequest(*request, ParsedJSON);
+	}
+	else
+	{
+		UE_LOG(SolanaRpcClient, Verbose, TEXT("Dropping response for unknown request %lld"), id);
+	}
+}
+
+void FSolanaRpcClient::CompleteDecodedResult(const FDecodedEntry& Entry)
+{
+	const uint32 Id = static_cast<uint32>(Entry.Id);
+	if( Entry.bError )
+	{
+		FailRequests({ Id }, FText::FromString(Entry.ErrorMessage));
+		return;
+	}
+
+	if( !Entry.Result )
+	{
+		FailRequests({ Id }, FText::FromString("Failed to parse Response from the server"));
+		return;
+	}
+
+	// The request may have timed out while its response was being decoded.
+	const TUniquePtr<FRequestData> Request = TakePendingRequest(Id);
+	if( !Request )
+	{
+		return;
+	}
+
+	FRequestCache::StoreResult(*Request, Entry.Result, Entry.Slot, CacheScope);
+
+	if( Request->ResultCallback )
+	{
+		Request->ResultCallback(*Entry.Result);
+	}
+	for( const TUniquePtr<FRequestData>& Duplicate : Request->Duplicates )
+	{
+		if( Duplicate->ResultCallback )
+		{
+			Duplicate->ResultCallback(*Entry.Result);
+		}
+	}
+}
+
+void FSolanaRpcClient::CompleteRequest(FRequestData& Request, const TSharedPtr<FJsonObject>& Response)
+{
+	if( Request.Method == TEXT("sendTransaction") )
+	{
+		// Reads answered while the transaction was in flight may already be outdated.
+		for( const FString& PubKey : Request.AccountKeys )
+		{
+			FRequestCache::Invalidate(PubKey);
+		}
+	}
+	else
+	{
+		FRequestCache::Store(Request, Response, CacheScope);
+	}
+
+	Request.Callback.ExecuteIfBound(*Response);
+	for( const TUniquePtr<FRequestData>& Duplicate : Request.Duplicates )
+	{
+		Duplicate->Callback.ExecuteIfBound(*Response);
+	}
+}
+
+void FSolanaRpcClient::CancelRequest(FRequestData* RequestData)
+{
+	if (RequestData)
+	{
+		CancelRequest(RequestData->Id);
+	}
+}
+
+void FSolanaRpcClient::CancelRequest(uint32 Id)
+{
+	if( TUniquePtr<FRequestData>* Pending = PendingRequests.Find(Id) )
+	{
+		Stats.Cancelled++;
+		FRequestData& Request = **Pending;
+		if( Request.Duplicates.Num() > 0 )
+		{
+			// Identical reads still wait on this response, so only the callbacks of this one go.
+			Request.bCancelled = true;
+			Request.Callback.Unbind();
+			Request.ErrorCallback.Unbind();
+			Request.ResultCallback = nullptr;
+			return;
+		}
+
+		TakePendingRequest(Id);
+		QueuedRequests.Remove(Id);
+		AbortOrphanedPosts();
+		return;
+	}
+
+	// A duplicate rides along with another request and simply leaves it.
+	for( TPair<uint32, TUniquePtr<FRequestData>>& Entry : PendingRequests )
+	{
+		TArray<TUniquePtr<FRequestData>>& Duplicates = Entry.Value->Duplicates;
+		const int32 Index = Duplicates.IndexOfByPredicate([Id](const TUniquePtr<FRequestData>& Duplicate){ return Duplicate->Id == Id; });
+		if( Index != INDEX_NONE )
+		{
+			Stats.Cancelled++;
+			Duplicates.RemoveAt(Index);
+
+			// The last reader of a cancelled request is gone, so it goes the way it would have on its own.
+			if( Duplicates.Num() == 0 && Entry.Value->bCancelled )
+			{
+				const uint32 PrimaryId = Entry.Key;
+				TakePendingRequest(PrimaryId);
+				QueuedRequests.Remove(PrimaryId);
+				AbortOrphanedPosts();
+			}
+			return;
+		}
+	}
+}
+
+void FSolanaRpcClient::AbortOrphanedPosts()
+{
+	bool bAborted = false;
+	for( int32 Index = InFlightPosts.Num() - 1; Index >= 0; Index-- )
+	{
+		const FInFlightPost& Post = InFlightPosts[Index];
+		if( Post.Ids.ContainsByPredicate([this](uint32 Id){ return PendingRequests.Contains(Id); }) )
+		{
+			continue;
+		}
+
+		// Removed first, so the completion the abort fires finds nothing to do.
+		const FHttpRequestPtr Request = Post.Request;
+		InFlightPosts.RemoveAtSwap(Index);
+		Request->CancelRequest();
+		bAborted = true;
+	}
+
+	if( bAborted )
+	{
+		PumpSendQueue();
+	}
+}
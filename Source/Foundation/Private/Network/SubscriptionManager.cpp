@@ -0,0 +1,330 @@
+/*
+Copyright 2022 ATMTA, Inc.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+	http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+*/
+
+#include "Network/SubscriptionManager.h"
+
+#include "IWebSocket.h"
+#include "WebSocketsModule.h"
+#include "Containers/Ticker.h"
+#include "Dom/JsonObject.h"
+#include "Serialization/JsonReader.h"
+#include "Serialization/JsonSerializer.h"
+
+#include "FoundationSettings.h"
+
+DECLARE_LOG_CATEGORY_CLASS(SubscriptionManager, Log, All);
+
+static TSharedPtr<IWebSocket> Socket;
+static TMap<uint32, FSubscriptionData> Subscriptions;
+
+// Subscribe message id -> subscription handle, and node subscription id -> subscription handle.
+static TMap<int64, uint32> PendingSubscribes;
+static TMap<int64, uint32> ActiveSubscriptions;
+
+// Subscribe message id -> method, for subscriptions dropped before the node answered. Undone as soon as it does.
+static TMap<int64, FString> CancelledSubscribes;
+
+static uint32 LastHandle = 0;
+static int64 LastMessageID = 0;
+static int32 ReconnectAttempts = 0;
+static FTSTicker::FDelegateHandle ReconnectTimerHandle;
+
+constexpr float MaxReconnectDelay = 30.f;
+
+uint32 FSubscriptionManager::SubscribeAccount(const FString& PubKey, SubscriptionCallback Callback, const FString& Encoding, const FString& Commitment)
+{
+	const FString Params = FString::Printf(TEXT(R"(["%s",{"encoding":"%s","commitment":"%s"}])"), *PubKey, *Encoding, *Commitment);
+	return Subscribe(TEXT("accountSubscribe"), Params, MoveTemp(Callback));
+}
+
+uint32 FSubscriptionManager::SubscribeProgram(const FString& ProgramId, const FString& Filters, SubscriptionCallback Callback, const FString& Encoding, const FString& Commitment)
+{
+	FString Config = FString::Printf(TEXT(R"({"encoding":"%s","commitment":"%s")"), *Encoding, *Commitment);
+	if( !Filters.IsEmpty() )
+	{
+		Config.Append(FString::Printf(TEXT(R"(,"filters":%s)"), *Filters));
+	}
+	Config.AppendChar(TEXT('}'));
+
+	const FString Params = FString::Printf(TEXT(R"(["%s",%s])"), *ProgramId, *Config);
+	return Subscribe(TEXT("programSubscribe"), Params, MoveTemp(Callback));
+}
+
+uint32 FSubscriptionManager::SubscribeSignature(const FString& Signature, SubscriptionCallback Callback, const FString& Commitment)
+{
+	const FString Params = FString::Printf(TEXT(R"(["%s",{"commitment":"%s"}])"), *Signature, *Commitment);
+	return Subscribe(TEXT("signatureSubscribe"), Params, MoveTemp(Callback), true);
+}
+
+uint32 FSubscriptionManager::SubscribeSlot(SubscriptionCallback Callback)
+{
+	return Subscribe(TEXT("slotSubscribe"), TEXT("[]"), MoveTemp(Callback));
+}
+
+uint32 FSubscriptionManager::Subscribe(const FString& Method, const FString& Params, SubscriptionCallback Callback, bool bOneShot)
+{
+	const uint32 Handle = ++LastHandle;
+
+	FSubscriptionData& Subscription = Subscriptions.Add(Handle);
+	Subscription.Method = Method;
+	Subscription.Params = Params;
+	Subscription.Callback = MoveTemp(Callback);
+	Subscription.bOneShot = bOneShot;
+
+	if( IsConnected() )
+	{
+		SendSubscribe(Handle, Subscription);
+	}
+	else
+	{
+		Connect();
+	}
+	return Handle;
+}
+
+void FSubscriptionManager::Unsubscribe(uint32 Handle)
+{
+	FSubscriptionData Subscription;
+	if( !Subscriptions.RemoveAndCopyValue(Handle, Subscription) )
+	{
+		return;
+	}
+
+	if( Subscription.ServerId != INDEX_NONE )
+	{
+		ActiveSubscriptions.Remove(Subscription.ServerId);
+		SendUnsubscribe(Subscription.Method, Subscription.ServerId);
+	}
+	else if( const int64* RequestId = PendingSubscribes.FindKey(Handle) )
+	{
+		CancelledSubscribes.Add(*RequestId, Subscription.Method);
+		PendingSubscribes.Remove(*RequestId);
+	}
+
+	if( Subscriptions.Num() == 0 )
+	{
+		CloseSocket();
+	}
+}
+
+bool FSubscriptionManager::IsConnected()
+{
+	return Socket.IsValid() && Socket->IsConnected();
+}
+
+void FSubscriptionManager::Shutdown()
+{
+	Subscriptions.Empty();
+	CloseSocket();
+}
+
+void FSubscriptionManager::Connect()
+{
+	if( Socket.IsValid() || ReconnectTimerHandle.IsValid() )
+	{
+		return;
+	}
+
+	FString Url = GetDefault<UFoundationSettings>()->GetNetworkWebSocketURL();
+	if( Url.IsEmpty() )
+	{
+		Url = GetDefault<UFoundationSettings>()->GetNetwork() == ESolanaNetwork::DevNet ? "wss://api.devnet.solana.com" : "wss://api.mainnet-beta.solana.com";
+	}
+
+	FModuleManager::LoadModuleChecked<FWebSocketsModule>(TEXT("WebSockets"));
+	Socket = FWebSocketsModule::Get().CreateWebSocket(Url);
+	Socket->OnConnected().AddStatic(&FSubscriptionManager::OnConnected);
+	Socket->OnConnectionError().AddStatic(&FSubscriptionManager::OnConnectionError);
+	Socket->OnClosed().AddStatic(&FSubscriptionManager::OnClosed);
+	Socket->OnMessage().AddStatic(&FSubscriptionManager::OnMessage);
+	Socket->Connect();
+}
+
+void FSubscriptionManager::CloseSocket()
+{
+	if( ReconnectTimerHandle.IsValid() )
+	{
+		FTSTicker::GetCoreTicker().RemoveTicker(ReconnectTimerHandle);
+		ReconnectTimerHandle.Reset();
+	}
+
+	if( Socket.IsValid() )
+	{
+		Socket->OnConnected().Clear();
+		Socket->OnConnectionError().Clear();
+		Socket->OnClosed().Clear();
+		Socket->OnMessage().Clear();
+		Socket->Close();
+		Socket.Reset();
+	}
+
+	PendingSubscribes.Empty();
+	CancelledSubscribes.Empty();
+	ActiveSubscriptions.Empty();
+	ReconnectAttempts = 0;
+}
+
+void FSubscriptionManager::ScheduleReconnect()
+{
+	PendingSubscribes.Empty();
+	CancelledSubscribes.Empty();
+	ActiveSubscriptions.Empty();
+	for( TPair<uint32, FSubscriptionData>& Entry : Subscriptions )
+	{
+		Entry.Value.ServerId = INDEX_NONE;
+	}
+
+	if( !ReconnectTimerHandle.IsValid() )
+	{
+		const float Delay = FMath::Min(FMath::Pow(2.f, ReconnectAttempts), MaxReconnectDelay);
+		ReconnectAttempts++;
+		UE_LOG(SubscriptionManager, Log, TEXT("Reconnecting in %.0f seconds"), Delay);
+		ReconnectTimerHandle = FTSTicker::GetCoreTicker().AddTicker(FTickerDelegate::CreateStatic(&FSubscriptionManager::OnReconnectTimer), Delay);
+	}
+}
+
+bool FSubscriptionManager::OnReconnectTimer(float DeltaTime)
+{
+	ReconnectTimerHandle.Reset();
+
+	// The old socket is released here rather than inside its own callbacks.
+	Socket.Reset();
+	if( Subscriptions.Num() > 0 )
+	{
+		Connect();
+	}
+	return false;
+}
+
+void FSubscriptionManager::SendSubscribe(uint32 Handle, const FSubscriptionData& Subscription)
+{
+	const int64 RequestId = ++LastMessageID;
+	PendingSubscribes.Add(RequestId, Handle);
+	SendMessage(FString::Printf(TEXT(R"({"jsonrpc":"2.0","id":%lld,"method":"%s","params":%s})"), RequestId, *Subscription.Method, *Subscription.Params));
+}
+
+void FSubscriptionManager::SendUnsubscribe(const FString& Method, int64 ServerId)
+{
+	const FString UnsubscribeMethod = Method.Replace(TEXT("Subscribe"), TEXT("Unsubscribe"));
+	SendMessage(FString::Printf(TEXT(R"({"jsonrpc":"2.0","id":%lld,"method":"%s","params":[%lld]})"), ++LastMessageID, *UnsubscribeMethod, ServerId));
+}
+
+void FSubscriptionManager::SendMessage(const FString& Message)
+{
+	if( IsConnected() )
+	{
+		Socket->Send(Message);
+	}
+}
+
+void FSubscriptionManager::OnConnected()
+{
+	UE_LOG(SubscriptionManager, Log, TEXT("Connected, subscribing %d"), Subscriptions.Num());
+	ReconnectAttempts = 0;
+	for( const TPair<uint32, FSubscriptionData>& Entry : Subscriptions )
+	{
+		SendSubscribe(Entry.Key, Entry.Value);
+	}
+}
+
+void FSubscriptionManager::OnConnectionError(const FString& Error)
+{
+	UE_LOG(SubscriptionManager, Warning, TEXT("Connection error: %s"), *Error);
+	ScheduleReconnect();
+}
+
+void FSubscriptionManager::OnClosed(int32 StatusCode, const FString& Reason, bool bWasClean)
+{
+	UE_LOG(SubscriptionManager, Log, TEXT("Connection closed (%d): %s"), StatusCode, *Reason);
+	ScheduleReconnect();
+}
+
+void FSubscriptionManager::OnMessage(const FString& Message)
+{
+	TSharedPtr<FJsonObject> ParsedJSON;
+	TSharedRef<TJsonReader<TCHAR>> Reader = TJsonReaderFactory<>::Create(Message);
+	if( !FJsonSerializer::Deserialize(Reader, ParsedJSON) || !ParsedJSON.IsValid() )
+	{
+		UE_LOG(SubscriptionManager, Warning, TEXT("Failed to parse message from the server"));
+		return;
+	}
+
+	int64 Id;
+	if( ParsedJSON->TryGetNumberField("id", Id) )
+	{
+		uint32 Handle;
+		FString CancelledMethod;
+		int64 ServerId;
+		if( CancelledSubscribes.RemoveAndCopyValue(Id, CancelledMethod) )
+		{
+			// Nobody listens any more, but the node would keep pushing for the life of the socket.
+			if( ParsedJSON->TryGetNumberField("result", ServerId) )
+			{
+				SendUnsubscribe(CancelledMethod, ServerId);
+			}
+		}
+		else if( PendingSubscribes.RemoveAndCopyValue(Id, Handle) )
+		{
+			FSubscriptionData* Subscription = Subscriptions.Find(Handle);
+			if( Subscription && ParsedJSON->TryGetNumberField("result", ServerId) )
+			{
+				Subscription->ServerId = ServerId;
+				ActiveSubscriptions.Add(ServerId, Handle);
+			}
+			else if( Subscription )
+			{
+				const TSharedPtr<FJsonObject>* Error;
+				const FString Reason = ParsedJSON->TryGetObjectField("error", Error) ? (*Error)->GetStringField("message") : FString();
+				UE_LOG(SubscriptionManager, Warning, TEXT("%s failed: %s"), *Subscription->Method, *Reason);
+			}
+		}
+		return;
+	}
+
+	const TSharedPtr<FJsonObject>* Params;
+	if( !ParsedJSON->TryGetObjectField("params", Params) )
+	{
+		return;
+	}
+
+	int64 ServerId;
+	const TSharedPtr<FJsonObject>* Result;
+	if( !(*Params)->TryGetNumberField("subscription", ServerId) || !(*Params)->TryGetObjectField("result", Result) )
+	{
+		return;
+	}
+
+	const uint32* Handle = ActiveSubscriptions.Find(ServerId);
+	FSubscriptionData* Subscription = Handle ? Subscriptions.Find(*Handle) : nullptr;
+	if( !Subscription )
+	{
+		return;
+	}
+
+	// The callback may subscribe or unsubscribe, so nothing from the maps is used after it runs.
+	const uint32 SubscriptionHandle = *Handle;
+	const bool bOneShot = Subscription->bOneShot;
+	const SubscriptionCallback Callback = Subscription->Callback;
+
+	if( bOneShot )
+	{
+		ActiveSubscriptions.Remove(ServerId);
+		Subscriptions.Remove(SubscriptionHandle);
+	}
+
+	Callback.ExecuteIfBound(**Result);
+}
@@ -0,0 +1,199 @@
+/*
+Copyright 2022 ATMTA, Inc.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+	http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+*/
+
+#include "Network/TransactionSender.h"
+
+#include "Containers/Ticker.h"
+#include "Misc/Base64.h"
+#include "Network/BlockhashProvider.h"
+#include "Network/RequestManager.h"
+#include "Network/RequestUtils.h"
+#include "Network/SolanaRpcClient.h"
+
+#include "FoundationSettings.h"
+
+struct FOutgoingTransaction
+{
+	FString Transaction;
+	uint64 LastValidBlockHeight = 0;
+	TSharedPtr<FSolanaRpcClient> Client;
+	bool bSendInFlight = false;
+};
+
+static TMap<FString, FOutgoingTransaction> Outgoing;
+static TSet<const FSolanaRpcClient*> BlockHeightsInFlight;
+static FTSTicker::FDelegateHandle RebroadcastTimerHandle;
+
+FString FTransactionSender::Send(const TArray<uint8>& Transaction, const FBlockhashInfo& Blockhash, TransactionStatusCallback Callback, const TSharedPtr<FSolanaRpcClient>& Client)
+{
+	// Tracking starts before the first send, a fast confirmation must not slip by unnoticed.
+	const FString Signature = FConfirmationTracker::Track(Transaction, TransactionStatusCallback::CreateLambda([Callback](const FString& TransactionSignature, ETransactionStatus Status)
+	{
+		if( Status >= ETransactionStatus::Confirmed )
+		{
+			Stop(TransactionSignature);
+		}
+		Callback.ExecuteIfBound(TransactionSignature, Status);
+	}), false, Client);
+	if( Signature.IsEmpty() || Outgoing.Contains(Signature) )
+	{
+		return Signature;
+	}
+
+	FOutgoingTransaction& Entry = Outgoing.Add(Signature);
+	Entry.Transaction = FBase64::Encode(Transaction);
+	Entry.LastValidBlockHeight = Blockhash.LastValidBlockHeight;
+	Entry.Client = Client.IsValid() ? Client : TSharedPtr<FSolanaRpcClient>(FRequestManager::GetDefaultClient());
+
+	SendOnce(Signature, true);
+
+	if( !RebroadcastTimerHandle.IsValid() )
+	{
+		const float Interval = GetDefault<UFoundationSettings>()->GetRebroadcastInterval();
+		RebroadcastTimerHandle = FTSTicker::GetCoreTicker().AddTicker(FTickerDelegate::CreateStatic(&FTransactionSender::OnRebroadcastTimer), Interval);
+	}
+	return Signature;
+}
+
+void FTransactionSender::Shutdown()
+{
+	if( RebroadcastTimerHandle.IsValid() )
+	{
+		FTSTicker::GetCoreTicker().RemoveTicker(RebroadcastTimerHandle);
+		RebroadcastTimerHandle.Reset();
+	}
+	Outgoing.Empty();
+	BlockHeightsInFlight.Empty();
+}
+
+bool FTransactionSender::OnRebroadcastTimer(float DeltaTime)
+{
+	if( Outgoing.Num() == 0 )
+	{
+		RebroadcastTimerHandle.Reset();
+		return false;
+	}
+
+	TArray<FString> Signatures;
+	TArray<TSharedRef<FSolanaRpcClient>> Clients;
+	for( const TPair<FString, FOutgoingTransaction>& Pair : Outgoing )
+	{
+		Signatures.Add(Pair.Key);
+		Clients.AddUnique(Pair.Value.Client.ToSharedRef());
+	}
+
+	for( const FString& Signature : Signatures )
+	{
+		SendOnce(Signature, false);
+	}
+	for( const TSharedRef<FSolanaRpcClient>& Client : Clients )
+	{
+		RequestBlockHeight(Client);
+	}
+	return true;
+}
+
+void FTransactionSender::SendOnce(const FString& Signature, bool bFirstSend)
+{
+	FOutgoingTransaction* Entry = Outgoing.Find(Signature);
+	if( Entry == nullptr || Entry->bSendInFlight )
+	{
+		return;
+	}
+	Entry->bSendInFlight = true;
+
+	// Only the first send is simulated. Resends would fail it once the transaction has landed.
+	// The node is told not to retry on its own, its queue is what drops transactions under load.
+	FRequestData* request = FRequestUtils::SendTransaction(Entry->Transaction, !bFirstSend, 0);
+	request->Callback.BindLambda([Signature](FJsonObject& data)
+	{
+		if( FOutgoingTransaction* Sent = Outgoing.Find(Signature) )
+		{
+			Sent->bSendInFlight = false;
+		}
+	});
+	request->ErrorCallback.BindLambda([Signature, bFirstSend](const FText& FailureReason)
+	{
+		FOutgoingTransaction* Sent = Outgoing.Find(Signature);
+		if( Sent == nullptr )
+		{
+			return;
+		}
+		Sent->bSendInFlight = false;
+
+		if( bFirstSend )
+		{
+			Stop(Signature);
+			FConfirmationTracker::Fail(Signature);
+			FRequestUtils::DisplayError(FailureReason.ToString());
+		}
+	});
+	Entry->Client->SendRequest(request);
+}
+
+void FTransactionSender::RequestBlockHeight(const TSharedRef<FSolanaRpcClient>& Client)
+{
+	const FSolanaRpcClient* ClientPtr = &Client.Get();
+	if( BlockHeightsInFlight.Contains(ClientPtr) )
+	{
+		return;
+	}
+	BlockHeightsInFlight.Add(ClientPtr);
+
+	FRequestData* request = FRequestUtils::RequestBlockHeight();
+	request->Priority = ERequestPriority::Transaction;
+	request->Callback.BindLambda([ClientPtr](FJsonObject& data)
+	{
+		BlockHeightsInFlight.Remove(ClientPtr);
+		OnBlockHeightReceived(ClientPtr, FRequestUtils::ParseBlockHeightResponse(data));
+	});
+	request->ErrorCallback.BindLambda([ClientPtr](const FText& FailureReason)
+	{
+		BlockHeightsInFlight.Remove(ClientPtr);
+	});
+	Client->SendRequest(request);
+}
+
+void FTransactionSender::OnBlockHeightReceived(const FSolanaRpcClient* Client, uint64 BlockHeight)
+{
+	if( BlockHeight == 0 )
+	{
+		return;
+	}
+
+	FBlockhashProvider::ReportBlockHeight(Client, BlockHeight);
+
+	TArray<FString> ExpiredSignatures;
+	for( const TPair<FString, FOutgoingTransaction>& Pair : Outgoing )
+	{
+		if( Pair.Value.Client.Get() == Client && Pair.Value.LastValidBlockHeight != 0 && BlockHeight > Pair.Value.LastValidBlockHeight )
+		{
+			ExpiredSignatures.Add(Pair.Key);
+		}
+	}
+
+	for( const FString& Signature : ExpiredSignatures )
+	{
+		Stop(Signature);
+		FConfirmationTracker::Expire(Signature);
+	}
+}
+
+void FTransactionSender::Stop(const FString& Signature)
+{
+	Outgoing.Remove(Signature);
+}
@@ -25,22 +25,53 @@ Contributers: Daniele Calanna, Riccardo Torrisi
 
 FAccount::FAccount()
 {
-	PublicKeyData.SetNum(PublicKeySize);
 	PrivateKeyData.SetNum(PrivateKeySize);
 }
 
-TArray<uint8> FAccount::Sign(const TArray<uint8>& Transaction)
+FSignature FAccount::Sign(TConstArrayView<uint8> Transaction) const
 {
-	TArray<uint8> Signature;
-	Signature.SetNum(PrivateKeySize);
-	TArray<uint8> Message;
+	FSignature Signature;
 	FCryptoUtils::SignMessage(Signature, Transaction, PrivateKeyData);
 	return Signature;
 }
 
-void FAccount::Verify(const TArray<uint8>& Transaction, const TArray<uint8>& Signature)
+void FAccount::Verify(const TArray<uint8>& Transaction, const FSignature& Signature) const
 {
-	FCryptoUtils::VerifyMessage(Signature, Transaction,PublicKeyData);
+	FCryptoUtils::VerifyMessage(Signature, Transaction, PublicKeyData);
+}
+
+void FAccount::EncodeBase58Keys()
+{
+	PublicKey = PublicKeyData.ToBase58();
+	PrivateKey = HasPrivateKey() ? FBase58::EncodeBase58(PrivateKeyData.GetData(), PrivateKeyData.Num()) : FString();
+}
+
+bool FAccount::HasPrivateKey() const
+{
+	for( const uint8 Byte : PrivateKeyData )
+	{
+		if( Byte != 0 )
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
+void FAccount::PostSerialize(const FArchive& Ar)
+{
+	if( Ar.IsLoading() )
+	{
+		// A corrupt key is dropped rather than read as the system program.
+		if( !FPublicKey::TryFromBase58(PublicKey, PublicKeyData) )
+		{
+			PublicKey.Empty();
+		}
+		if( !PrivateKey.IsEmpty() )
+		{
+			PrivateKeyData = FBase58::DecodeBase58(PrivateKey);
+		}
+	}
 }
 
 FAccount FAccount::FromSeed( const TArray<uint8>& Seed )
@@ -50,9 +81,7 @@ FAccount FAccount::FromSeed( const TArray<uint8>& Seed )
 	FAccount newAccount;
 
 	FCryptoUtils::GenerateKeyPair(Seed,newAccount.PublicKeyData, newAccount.PrivateKeyData );
-
-	newAccount.PublicKey = FBase58::EncodeBase58(newAccount.PublicKeyData.GetData(), newAccount.PublicKeyData.Num());
-	newAccount.PrivateKey = FBase58::EncodeBase58(newAccount.PrivateKeyData.GetData(), newAccount.PrivateKeyData.Num());
+	newAccount.EncodeBase58Keys();
 
 	return newAccount;
 }
@@ -61,16 +90,14 @@ FAccount FAccount::FromPrivateKey(const FString& privateKey)
 {
 	FAccount newAccount;
 
-	newAccount.PrivateKey = privateKey;
 	newAccount.PrivateKeyData = FBase58::DecodeBase58(privateKey);
-
-	for(int i = 0; i < PublicKeySize; i++)
+	if( newAccount.PrivateKeyData.Num() == PrivateKeySize )
 	{
-		newAccount.PublicKeyData[i] = newAccount.PrivateKeyData[i + PublicKeySize];
+		newAccount.PublicKeyData = FPublicKey(newAccount.PrivateKeyData.GetData() + PublicKeySize);
+		newAccount.PublicKey = newAccount.PublicKeyData.ToBase58();
+		newAccount.PrivateKey = privateKey;
 	}
 
-	newAccount.PublicKey = FBase58::EncodeBase58(newAccount.PublicKeyData.GetData(), newAccount.PublicKeyData.Num());
-
 	return newAccount;
 }
 
@@ -79,33 +106,37 @@ FAccount FAccount::FromPrivateKey( const TArray<uint8>& PrivateKey )
 	FAccount newAccount;
 
 	newAccount.PrivateKeyData = PrivateKey;
-	for(int i = 0; i < PublicKeySize; i++)
-	{
-		newAccount.PublicKeyData[i] = PrivateKey[i + PublicKeySize];
-	}
-
-	newAccount.PublicKey = FBase58::EncodeBase58(newAccount.PublicKeyData.GetData(), newAccount.PublicKeyData.Num());
-	newAccount.PrivateKey = FBase58::EncodeBase58(newAccount.PrivateKeyData.GetData(), newAccount.PrivateKeyData.Num());
+	newAccount.PublicKeyData = FPublicKey(PrivateKey.GetData() + PublicKeySize);
+	newAccount.EncodeBase58Keys();
 
 	return newAccount;
 }
 
-FAccount FAccount::FromPublicKey(const FString& publicKey)
+bool FAccount::TryFromPublicKey(const FString& publicKey, FAccount& outAccount)
 {
-	FAccount newAccount;
-
-	newAccount.PublicKeyData = FBase58::DecodeBase58(publicKey);
-	newAccount.PublicKey = publicKey;
+	FPublicKey key;
+	if( !FPublicKey::TryFromBase58(publicKey, key) )
+	{
+		return false;
+	}
 
-	return newAccount;
+	outAccount = FAccount();
+	outAccount.PublicKeyData = key;
+	outAccount.PublicKey = publicKey;
+	return true;
 }
 
 FAccount FAccount::FromPublicKey(const TArray<uint8>& publicKey)
+{
+	return FromPublicKey(FPublicKey::FromBytes(publicKey));
+}
+
+FAccount FAccount::FromPublicKey(const FPublicKey& publicKey)
 {
 	FAccount newAccount;
 
 	newAccount.PublicKeyData = publicKey;
-	newAccount.PublicKey = FBase58::EncodeBase58(newAccount.PublicKeyData.GetData(), newAccount.PublicKeyData.Num());
+	newAccount.PublicKey = publicKey.ToBase58();
 
 	return newAccount;
 }
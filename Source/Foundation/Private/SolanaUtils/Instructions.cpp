@@ -19,8 +19,7 @@ Author: Jon Sawler
 #include "Instructions.h"
 
 #include "SolanaUtils/Account.h"
-#include "Crypto/Base58.h"
-#include "Crypto/CryptoUtils.h"
+#include "SolanaUtils/Utils/ByteWriter.h"
 #include "SolanaUtils/Utils/Types.h"
 
 constexpr int32 SystemProgramIndex_CreateAccount = 0;
@@ -35,18 +34,17 @@ FInstructionData FInstruction::TransferLamports(const FAccount& from, const FAcc
 {
 	FInstructionData result;
 
-	TArray<uint8> SystemProgramId;
-	SystemProgramId.SetNumZeroed(PublicKeySize);
-	
-	result.ProgramId.Append(SystemProgramId);
+	// The system program id is all zeroes.
+	result.ProgramId = FPublicKey();
 	
 	result.Keys.Add(FAccountMeta( from.PublicKeyData, true, true));
 	result.Keys.Add(FAccountMeta( to.PublicKeyData, false, true));
 
 	result.Keys.Add(FAccountMeta( result.ProgramId, false, false));
 	
-	result.Data.Append(FCryptoUtils::Int32ToDataArray(SystemProgramIndex_Transfer));
-	result.Data.Append(FCryptoUtils::Int64ToDataArray(lamports));
+	FByteWriter data(result.Data, 12);
+	data.WriteU32(SystemProgramIndex_Transfer);
+	data.WriteU64(lamports);
 	
 	return result;
 }
@@ -55,34 +53,32 @@ FInstructionData FInstruction::CreateAccount(const FAccount& from, const FAccoun
 {
 	FInstructionData result;
 
-	TArray<uint8> systemProgramId;
-	systemProgramId.SetNumZeroed(PublicKeySize);
-	
-	result.ProgramId.Append(systemProgramId);
+	result.ProgramId = FPublicKey();
 	
 	result.Keys.Add(FAccountMeta( from.PublicKeyData, true, true));
 	result.Keys.Add(FAccountMeta( newAccount.PublicKeyData, true, true));
 	
 	result.Keys.Add(FAccountMeta( result.ProgramId, false, false));
 	
-	result.Data.Append(FCryptoUtils::Int32ToDataArray(SystemProgramIndex_CreateAccount));
-	result.Data.Append(FCryptoUtils::Int64ToDataArray(rent));
-	result.Data.Append(FCryptoUtils::Int64ToDataArray(AccountDataSize));
-	result.Data.Append(FBase58::DecodeBase58(TokenProgramId));
+	FByteWriter data(result.Data, 52);
+	data.WriteU32(SystemProgramIndex_CreateAccount);
+	data.WriteU64(rent);
+	data.WriteU64(AccountDataSize);
+	data.WriteKey(FPublicKey::FromBase58(TokenProgramId));
 	
 	return result;
 }
 
-FInstructionData FInstruction::InitializeTokenAccount(const FAccount& account, const TArray<uint8>& mint, const FAccount& owner)
+FInstructionData FInstruction::InitializeTokenAccount(const FAccount& account, const FPublicKey& mint, const FAccount& owner)
 {
 	FInstructionData result;
 
-	result.ProgramId.Append(FBase58::DecodeBase58(TokenProgramId));
+	result.ProgramId = FPublicKey::FromBase58(TokenProgramId);
 	
 	result.Keys.Add(FAccountMeta( account.PublicKeyData, false, true));
 	result.Keys.Add(FAccountMeta( mint, false, false));
 	result.Keys.Add(FAccountMeta( owner.PublicKeyData, false, false));
-	result.Keys.Add(FAccountMeta( FBase58::DecodeBase58(SysvarRentPublicKey), false, false));
+	result.Keys.Add(FAccountMeta( FPublicKey::FromBase58(SysvarRentPublicKey), false, false));
 
 	result.Keys.Add(FAccountMeta( result.ProgramId, false, false));
 	
@@ -95,7 +91,7 @@ FInstructionData FInstruction::TransferTokens(const FAccount& from, const FAccou
 {
 	FInstructionData result;
 	
-	result.ProgramId.Append(FBase58::DecodeBase58(TokenProgramId));
+	result.ProgramId = FPublicKey::FromBase58(TokenProgramId);
 	
 	result.Keys.Add(FAccountMeta( from.PublicKeyData, false, true));
 	result.Keys.Add(FAccountMeta( to.PublicKeyData, false, true));
@@ -104,8 +100,9 @@ FInstructionData FInstruction::TransferTokens(const FAccount& from, const FAccou
 	result.Keys.Add(FAccountMeta( result.ProgramId, false, false));
 
 	//Finish this
-	result.Data.Add(TokenProgramIndex_Transfer);
-	result.Data.Append(FCryptoUtils::Int64ToDataArray(amount));
+	FByteWriter data(result.Data, 9);
+	data.WriteU8(TokenProgramIndex_Transfer);
+	data.WriteU64(amount);
 	
 	return result;
 }
@@ -16,32 +16,40 @@ limitations under the License.
 Author: Jon Sawler
 */
 #pragma once
-#include "Crypto/Base58.h"
+#include "SolanaUtils/PublicKey.h"
 #include "SolanaUtils/Utils/Types.h"
 
 struct FAccount;
 
 struct FAccountMeta
 {
-	FAccountMeta(const TArray<uint8>& publicKeyData, bool signer, bool writable)
-		: PublicKey(FBase58::EncodeBase58(publicKeyData.GetData(),publicKeyData.Num())),
-			PublicKeyData(publicKeyData), Signer(signer), Writable(writable)
+	FAccountMeta(const FPublicKey& publicKeyData, bool signer, bool writable)
+		: PublicKeyData(publicKeyData), Signer(signer), Writable(writable)
 	{
-		if( PublicKeyData.Num() < PublicKeySize )
+	}
+
+	// Base58 of the key, encoded on first use. Transactions are compiled from the binary key alone.
+	const FString& GetPublicKey() const
+	{
+		if( PublicKey.IsEmpty() )
 		{
-			PublicKeyData.AddZeroed( PublicKeySize - PublicKeyData.Num() );
+			PublicKey = PublicKeyData.ToBase58();
 		}
+		return PublicKey;
 	}
 	
-	FString PublicKey;
-	TArray<uint8> PublicKeyData;
+	FPublicKey PublicKeyData;
 	bool Signer;
 	bool Writable;
+
+private:
+
+	mutable FString PublicKey;
 };
 
 struct FInstructionData
 {
-	TArray<uint8> ProgramId;
+	FPublicKey ProgramId;
 	TArray<FAccountMeta> Keys;
 	TArray<uint8> Data;
 };
@@ -53,6 +61,6 @@ public:
 	static FInstructionData TransferLamports(const FAccount& from, const FAccount& to, int64 lamports);
 	static FInstructionData CreateAccount(const FAccount& from, const FAccount& newAccount, int64 rent);
 
-	static FInstructionData InitializeTokenAccount(const FAccount& account, const TArray<uint8>& mint, const FAccount& owner);
+	static FInstructionData InitializeTokenAccount(const FAccount& account, const FPublicKey& mint, const FAccount& owner);
 	static FInstructionData TransferTokens(const FAccount& from, const FAccount& to, const FAccount& owner, int64 amount);
 };
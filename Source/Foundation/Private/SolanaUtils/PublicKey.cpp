@@ -0,0 +1,95 @@
+/*
+Copyright 2022 ATMTA, Inc.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+	http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+*/
+
+#include "SolanaUtils/PublicKey.h"
+
+#include "Crypto/Base58.h"
+#include "Hash/CityHash.h"
+
+static_assert(sizeof(FPublicKey) == FPublicKey::Size, "FPublicKey must stay a plain 32 byte value");
+static_assert(sizeof(FSignature) == FSignature::Size, "FSignature must stay a plain 64 byte value");
+
+FPublicKey FPublicKey::FromBytes(const TArray<uint8>& Data)
+{
+	FPublicKey Key;
+	FMemory::Memcpy(Key.Bytes, Data.GetData(), FMath::Min(Data.Num(), Size));
+	return Key;
+}
+
+FPublicKey FPublicKey::FromBase58(const FString& Key)
+{
+	FPublicKey Result;
+	ensureMsgf(TryFromBase58(Key, Result), TEXT("Invalid base58 key %s"), *Key);
+	return Result;
+}
+
+bool FPublicKey::TryFromBase58(const FString& Key, FPublicKey& OutKey)
+{
+	if( FBase58::DecodeFixed(*Key, Key.Len(), OutKey.Bytes, Size) != EBase58Error::None )
+	{
+		FMemory::Memzero(OutKey.Bytes);
+		return false;
+	}
+	return true;
+}
+
+FString FPublicKey::ToBase58() const
+{
+	TCHAR Buffer[FBase58::MaxEncodedLength(Size)];
+	const int32 Length = FBase58::EncodeFixed(Bytes, Size, Buffer);
+	return FString(Length, Buffer);
+}
+
+bool FPublicKey::IsZero() const
+{
+	for( const uint8 Byte : Bytes )
+	{
+		if( Byte != 0 )
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+// Program and sysvar ids are picked for their base58 prefix and share leading bytes, so the whole key is hashed.
+uint32 GetTypeHash(const FPublicKey& Key)
+{
+	return CityHash32(reinterpret_cast<const char*>(Key.Bytes), FPublicKey::Size);
+}
+
+FSignature FSignature::FromBase58(const FString& Signature)
+{
+	FSignature Result;
+	if( FBase58::DecodeFixed(*Signature, Signature.Len(), Result.Bytes, Size) != EBase58Error::None )
+	{
+		FMemory::Memzero(Result.Bytes);
+	}
+	return Result;
+}
+
+FString FSignature::ToBase58() const
+{
+	TCHAR Buffer[FBase58::MaxEncodedLength(Size)];
+	const int32 Length = FBase58::EncodeFixed(Bytes, Size, Buffer);
+	return FString(Length, Buffer);
+}
+
+uint32 GetTypeHash(const FSignature& Signature)
+{
+	return CityHash32(reinterpret_cast<const char*>(Signature.Bytes), FSignature::Size);
+}
@@ -20,8 +20,7 @@ Author: Jon Sawler
 
 #include "SolanaUtils/Account.h"
 #include "Instructions.h"
-#include "Crypto/Base58.h"
-#include "Crypto/CryptoUtils.h"
+#include "SolanaUtils/Utils/ByteWriter.h"
 
 FTransaction::FTransaction(const FString& currentBlockHash)
 {
@@ -37,36 +36,37 @@ void FTransaction::AddInstruction(const FInstructionData& instruction)
 	Instructions.Add(instruction);
 	for( const FAccountMeta& data: instruction.Keys)
 	{
-		int index = AccountList.IndexOfByPredicate([data](const FAccountMeta& entry){ return data.PublicKeyData == entry.PublicKeyData; } );
-		if(index == INDEX_NONE)
-		{
-			AccountList.Add(data);
-		}
-		else
-		{
-			if( data.Writable && !AccountList[index].Writable )
-			{
-				AccountList[index] = data;
-			}
-		}
+		AddAccount(data.PublicKeyData, data.Signer, data.Writable);
 	}
 }
 
 void FTransaction::AddInstructions(const TArray<FInstructionData>& instructions)
 {
-	Instructions.Append(instructions);
+	Instructions.Reserve(Instructions.Num() + instructions.Num());
 	for(const FInstructionData& instruction: instructions)
 	{
 		AddInstruction(instruction);
 	}
 }
 
-uint8 FTransaction::GetAccountIndex(const FString& key) const
+void FTransaction::AddAccount(const FPublicKey& key, bool signer, bool writable)
 {
-	return AccountList.IndexOfByPredicate([key](const FAccountMeta& data)
+	// An account referenced more than once takes the widest access any reference asks for.
+	if( const int32* index = AccountIndices.Find(key) )
 	{
-		return data.PublicKey == key;
-	});
+		FAccountMeta& entry = AccountList[*index];
+		entry.Signer = entry.Signer || signer;
+		entry.Writable = entry.Writable || writable;
+	}
+	else
+	{
+		AccountIndices.Add(key, AccountList.Add(FAccountMeta(key, signer, writable)));
+	}
+}
+
+uint8 FTransaction::GetAccountIndex(const FPublicKey& key) const
+{
+	return AccountIndices.FindChecked(key);
 }
 
 TArray<uint8> FTransaction::Build(const FAccount& signer)
@@ -78,90 +78,140 @@ TArray<uint8> FTransaction::Build(const FAccount& signer)
 
 TArray<uint8> FTransaction::Build(const TArray<FAccount>& signers)
 {
+	TArray<uint8> result;
+
+	// Blockhashes share the 32 byte key encoding.
+	FPublicKey blockHash;
+	if( !FPublicKey::TryFromBase58(BlockHash, blockHash) )
+	{
+		return result;
+	}
+
 	UpdateAccountList(signers);
 
-	const TArray<uint8> message = BuildMessage();
+	FByteWriter writer(result, MaxTransactionSize);
+
+	// Signatures precede the message they sign, so their slots are filled in once it has been written.
+	writer.WriteCompactU16(signers.Num());
+	const int32 signaturesOffset = writer.WriteZeroes(signers.Num() * FSignature::Size);
+	const int32 messageOffset = writer.Num();
+
+	BuildMessage(writer, blockHash);
+
+	const TConstArrayView<uint8> message(result.GetData() + messageOffset, result.Num() - messageOffset);
+	for( int32 i = 0; i < signers.Num(); i++ )
+	{
+		const FSignature signature = signers[i].Sign(message);
+		FMemory::Memcpy(result.GetData() + signaturesOffset + i * FSignature::Size, signature.GetData(), FSignature::Size);
+	}
 
-	TArray<uint8> result = Sign(message, signers);
-	result.Append(message);
-	
 	return result;
 }
 
+// Message order after the Build signers: writable signers, read-only signers, writable accounts, read-only accounts.
+static int32 GetAccountGroup(const FAccountMeta& account)
+{
+	return account.Signer ? (account.Writable ? 0 : 1) : (account.Writable ? 2 : 3);
+}
+
 void FTransaction::UpdateAccountList(const TArray<FAccount>& signers)
 {
 	for (const FAccount& account : signers)
 	{
-		int index = 0;
-		while( index != INDEX_NONE )
+		AddAccount(account.PublicKeyData, true, true);
+	}
+
+	const int32 numAccounts = AccountList.Num();
+	TArray<int32> positions;
+	positions.Init(INDEX_NONE, numAccounts);
+
+	// The Build signers lead in the order given, fee payer first.
+	int32 next = 0;
+	for (const FAccount& account : signers)
+	{
+		int32& position = positions[AccountIndices.FindChecked(account.PublicKeyData)];
+		if( position == INDEX_NONE )
 		{
-			index = AccountList.IndexOfByPredicate([account](const FAccountMeta& entry){ return account.PublicKeyData == entry.PublicKeyData; } );
-			if( index != INDEX_NONE )
-			{
-				AccountList.RemoveAt(index);
-			}
+			position = next++;
 		}
 	}
 
-	//Sort writables to the top of list before readding Signers at the very top
-	AccountList.Sort([](const FAccountMeta& A, const FAccountMeta& B) { return A.Writable && !B.Writable; });
+	// The rest are partitioned into their groups in one stable counting pass.
+	int32 groupStarts[4] = {};
+	for (int32 i = 0; i < numAccounts; i++)
+	{
+		if( positions[i] == INDEX_NONE )
+		{
+			groupStarts[GetAccountGroup(AccountList[i])]++;
+		}
+	}
+	for (int32& start : groupStarts)
+	{
+		const int32 size = start;
+		start = next;
+		next += size;
+	}
 
-	for (int i = 0; i < signers.Num(); i++)
+	TArray<int32> order;
+	order.SetNumUninitialized(numAccounts);
+	for (int32 i = 0; i < numAccounts; i++)
 	{
-		AccountList.Insert( FAccountMeta( signers[i].PublicKeyData, true, true), i);
+		if( positions[i] == INDEX_NONE )
+		{
+			positions[i] = groupStarts[GetAccountGroup(AccountList[i])]++;
+		}
+		order[positions[i]] = i;
 	}
+
+	RequiredSignatures = 0;
+	ReadOnlySignedAccounts = 0;
+	ReadOnlyUnsignedAccounts = 0;
+
+	TArray<FAccountMeta> ordered;
+	ordered.Reserve(numAccounts);
+	for (int32 position = 0; position < numAccounts; position++)
+	{
+		FAccountMeta& account = AccountList[order[position]];
+		UpdateHeaderInfo(account);
+		AccountIndices.FindChecked(account.PublicKeyData) = position;
+		ordered.Add(MoveTemp(account));
+	}
+	AccountList = MoveTemp(ordered);
 }
 
-TArray<uint8> FTransaction::BuildMessage()
+void FTransaction::BuildMessage(FByteWriter& writer, const FPublicKey& blockHash)
 {
-    TArray<uint8> accountKeysBuffer;
-    for (FAccountMeta& accountMeta : AccountList)
-    {
-    	//Need to remove feepayer here????
-        accountKeysBuffer.Append(accountMeta.PublicKeyData);
-		UpdateHeaderInfo(accountMeta);
-    }
-
-	TArray<uint8> buffer;
-	buffer.Add(RequiredSignatures);
-	buffer.Add(ReadOnlySignedAccounts);
-	buffer.Add(ReadOnlyUnsignedAccounts);
-	
-	buffer.Append(FCryptoUtils::ShortVectorEncodeLength(AccountList.Num()));
-	buffer.Append(accountKeysBuffer);
-
-	buffer.Append( FBase58::DecodeBase58(BlockHash));
-
-	TArray<uint8> compiledInstructions = CompileInstructions();
-	buffer.Append(FCryptoUtils::ShortVectorEncodeLength(Instructions.Num()));
-	buffer.Append(compiledInstructions);
-
-	return buffer;
+	writer.WriteU8(RequiredSignatures);
+	writer.WriteU8(ReadOnlySignedAccounts);
+	writer.WriteU8(ReadOnlyUnsignedAccounts);
+
+	writer.WriteCompactU16(AccountList.Num());
+	for (const FAccountMeta& accountMeta : AccountList)
+	{
+		writer.WriteKey(accountMeta.PublicKeyData);
+	}
+
+	writer.WriteKey(blockHash);
+
+	writer.WriteCompactU16(Instructions.Num());
+	CompileInstructions(writer);
 }
 
-TArray<uint8> FTransaction::CompileInstructions()
+void FTransaction::CompileInstructions(FByteWriter& writer)
 {
-	TArray<uint8> result;
-	
-	for (FInstructionData& instruction: Instructions)
+	for (const FInstructionData& instruction: Instructions)
 	{
 		const int keyCount = instruction.Keys.Num() - 1;
-		TArray<uint8> keyIndices;
-		keyIndices.SetNum(keyCount);
-	
+
+		writer.WriteU8(GetAccountIndex(instruction.ProgramId));
+		writer.WriteCompactU16(keyCount);
 		for (int i = 0; i < keyCount; i++)
 		{
-			keyIndices[i] = GetAccountIndex(instruction.Keys[i].PublicKey);
+			writer.WriteU8(GetAccountIndex(instruction.Keys[i].PublicKeyData));
 		}
-
-		result.Add(GetAccountIndex(FBase58::EncodeBase58(instruction.ProgramId.GetData(),instruction.ProgramId.Num())));
-		result.Append(FCryptoUtils::ShortVectorEncodeLength(keyCount));
-		result.Append(keyIndices);
-		result.Append(FCryptoUtils::ShortVectorEncodeLength(instruction.Data.Num()));
-		result.Append(instruction.Data);
+		writer.WriteCompactU16(instruction.Data.Num());
+		writer.WriteBytes(instruction.Data);
 	}
-
-	return result;
 }
 
 void FTransaction::UpdateHeaderInfo(const FAccountMeta& accountMeta)
@@ -178,17 +228,3 @@ void FTransaction::UpdateHeaderInfo(const FAccountMeta& accountMeta)
 			ReadOnlyUnsignedAccounts += 1;
 	}
 }
-
-TArray<uint8> FTransaction::Sign(const TArray<uint8>& message, const TArray<FAccount>& signers)
-{
-	TArray<uint8> signatures;
-
-	signatures.Append(FCryptoUtils::ShortVectorEncodeLength(signers.Num()));
-	
-	for(FAccount signer: signers)
-	{
-		signatures.Append( signer.Sign(message) );
-	}
-
-	return signatures;
-}
\ No newline at end of file
@@ -17,10 +17,15 @@ Author: Jon Sawler
 */
 #pragma once
 
+#include "SolanaUtils/PublicKey.h"
+
 struct FAccount;
 struct FAccountMeta;
 struct FInstructionData;
 
+template<typename AllocatorType> class TByteWriter;
+using FByteWriter = TByteWriter<FDefaultAllocator>;
+
 class FTransaction
 {
 public:
@@ -30,23 +35,25 @@ public:
 	void AddInstruction(const FInstructionData& instruction);
 	void AddInstructions(const TArray<FInstructionData>& instructions);
 	
+	// Empty if the blockhash is not valid base58.
 	TArray<uint8> Build(const FAccount& signer);
 	TArray<uint8> Build(const TArray<FAccount>& signers);
 
-	static TArray<uint8> Sign(const TArray<uint8>& message, const TArray<FAccount>& signers);
-
 private:
 
-	TArray<uint8> BuildMessage();
-	TArray<uint8> CompileInstructions();
+	void BuildMessage(FByteWriter& writer, const FPublicKey& blockHash);
+	void CompileInstructions(FByteWriter& writer);
 
+	void AddAccount(const FPublicKey& key, bool signer, bool writable);
 	void UpdateAccountList(const TArray<FAccount>& signers);
 	void UpdateHeaderInfo(const FAccountMeta& accountMeta);
 
-	uint8 GetAccountIndex(const FString& key) const;
+	uint8 GetAccountIndex(const FPublicKey& key) const;
 
 	TArray<FInstructionData> Instructions;
 	TArray<FAccountMeta> AccountList;
+	// Position of each key in AccountList.
+	TMap<FPublicKey, int32> AccountIndices;
 
 	FString BlockHash;
 
@@ -0,0 +1,238 @@
+/*
+Copyright 2022 ATMTA, Inc.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+	http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+*/
+
+#pragma once
+
+#include "SolanaUtils/PublicKey.h"
+
+// Largest serialized transaction the cluster accepts, the IPv6 minimum MTU less headers.
+constexpr int32 MaxTransactionSize = 1232;
+
+/**
+ * TByteWriter
+ *
+ * Appends the Solana wire format to a caller owned array: compact-u16 lengths, little endian integers and raw keys.
+ * Pass a TArray with a TInlineAllocator to serialize on the stack.
+ */
+template<typename AllocatorType = FDefaultAllocator>
+class TByteWriter
+{
+public:
+
+	explicit TByteWriter(TArray<uint8, AllocatorType>& InBuffer, int32 ExpectedSize = 0)
+		: Buffer(InBuffer)
+	{
+		Buffer.Reserve(Buffer.Num() + ExpectedSize);
+	}
+
+	void WriteU8(uint8 Value)
+	{
+		Buffer.Add(Value);
+	}
+
+	void WriteU32(uint32 Value)
+	{
+		uint8* Out = Grow(4);
+		for( int32 Index = 0; Index < 4; Index++ )
+		{
+			Out[Index] = static_cast<uint8>(Value >> (8 * Index));
+		}
+	}
+
+	void WriteU64(uint64 Value)
+	{
+		uint8* Out = Grow(8);
+		for( int32 Index = 0; Index < 8; Index++ )
+		{
+			Out[Index] = static_cast<uint8>(Value >> (8 * Index));
+		}
+	}
+
+	// Seven bits per byte, low bits first, with the top bit set on every byte but the last.
+	void WriteCompactU16(int32 Value)
+	{
+		check(Value >= 0 && Value <= MAX_uint16);
+
+		uint32 Remaining = static_cast<uint32>(Value);
+		while( Remaining >= 0x80 )
+		{
+			Buffer.Add(static_cast<uint8>((Remaining & 0x7f) | 0x80));
+			Remaining >>= 7;
+		}
+		Buffer.Add(static_cast<uint8>(Remaining));
+	}
+
+	void WriteBytes(const uint8* Data, int32 Size)
+	{
+		Buffer.Append(Data, Size);
+	}
+
+	void WriteBytes(TConstArrayView<uint8> Data)
+	{
+		Buffer.Append(Data.GetData(), Data.Num());
+	}
+
+	void WriteKey(const FPublicKey& Key)
+	{
+		Buffer.Append(Key.GetData(), FPublicKey::Size);
+	}
+
+	void WriteSignature(const FSignature& Signature)
+	{
+		Buffer.Append(Signature.GetData(), FSignature::Size);
+	}
+
+	// Zero filled space to be patched later, returning its offset.
+	int32 WriteZeroes(int32 Size)
+	{
+		return Buffer.AddZeroed(Size);
+	}
+
+	int32 Num() const { return Buffer.Num(); }
+
+private:
+
+	uint8* Grow(int32 Size)
+	{
+		return Buffer.GetData() + Buffer.AddUninitialized(Size);
+	}
+
+	TArray<uint8, AllocatorType>& Buffer;
+};
+
+using FByteWriter = TByteWriter<FDefaultAllocator>;
+
+/**
+ * FByteReader
+ *
+ * Reads the same format back out of a byte view. Every read fails rather than running past the end.
+ */
+class FByteReader
+{
+public:
+
+	explicit FByteReader(TConstArrayView<uint8> InData)
+		: Data(InData)
+	{
+	}
+
+	bool ReadU8(uint8& OutValue)
+	{
+		if( Remaining() < 1 )
+		{
+			return false;
+		}
+		OutValue = Data[Offset++];
+		return true;
+	}
+
+	bool ReadU32(uint32& OutValue)
+	{
+		if( Remaining() < 4 )
+		{
+			return false;
+		}
+		OutValue = 0;
+		for( int32 Index = 3; Index >= 0; Index-- )
+		{
+			OutValue = (OutValue << 8) | Data[Offset + Index];
+		}
+		Offset += 4;
+		return true;
+	}
+
+	bool ReadU64(uint64& OutValue)
+	{
+		if( Remaining() < 8 )
+		{
+			return false;
+		}
+		OutValue = 0;
+		for( int32 Index = 7; Index >= 0; Index-- )
+		{
+			OutValue = (OutValue << 8) | Data[Offset + Index];
+		}
+		Offset += 8;
+		return true;
+	}
+
+	// At most three bytes, the last of which only carries two bits.
+	bool ReadCompactU16(int32& OutValue)
+	{
+		OutValue = 0;
+		for( int32 Shift = 0; Shift < 21; Shift += 7 )
+		{
+			uint8 Byte;
+			if( !ReadU8(Byte) )
+			{
+				return false;
+			}
+			OutValue |= (Byte & 0x7f) << Shift;
+			if( (Byte & 0x80) == 0 )
+			{
+				return OutValue <= MAX_uint16;
+			}
+		}
+		return false;
+	}
+
+	bool ReadKey(FPublicKey& OutKey)
+	{
+		if( Remaining() < FPublicKey::Size )
+		{
+			return false;
+		}
+		OutKey = FPublicKey(Data.GetData() + Offset);
+		Offset += FPublicKey::Size;
+		return true;
+	}
+
+	bool ReadSignature(FSignature& OutSignature)
+	{
+		if( Remaining() < FSignature::Size )
+		{
+			return false;
+		}
+		OutSignature = FSignature(Data.GetData() + Offset);
+		Offset += FSignature::Size;
+		return true;
+	}
+
+	bool Skip(int32 Size)
+	{
+		if( Size < 0 || Remaining() < Size )
+		{
+			return false;
+		}
+		Offset += Size;
+		return true;
+	}
+
+	// The next Size bytes without copying them, or nullptr if they run past the end.
+	const uint8* Peek(int32 Size) const
+	{
+		return Size >= 0 && Remaining() >= Size ? Data.GetData() + Offset : nullptr;
+	}
+
+	int32 GetOffset() const { return Offset; }
+	int32 Remaining() const { return Data.Num() - Offset; }
+
+private:
+
+	TConstArrayView<uint8> Data;
+	int32 Offset = 0;
+};
@@ -0,0 +1,105 @@
+/*
+Copyright 2022 ATMTA, Inc.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+	http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+*/
+#include "SolanaUtils/Utils/TokenLayout.h"
+
+#include "Crypto/Base58.h"
+#include "Misc/Base64.h"
+
+static uint64 ReadU64(const uint8* Data)
+{
+	uint64 Value = 0;
+	for( int32 Index = 7; Index >= 0; Index-- )
+	{
+		Value = (Value << 8) | Data[Index];
+	}
+	return Value;
+}
+
+// COption tags are little endian u32s: 0 for None, 1 for Some.
+static bool ReadOptionTag(const uint8* Data)
+{
+	return Data[0] != 0 || Data[1] != 0 || Data[2] != 0 || Data[3] != 0;
+}
+
+bool FTokenAccountLayout::Decode(const uint8* Data, int32 Size, FTokenAccountLayout& OutAccount)
+{
+	if( Size < AccountDataSize )
+	{
+		return false;
+	}
+
+	FMemory::Memcpy(OutAccount.Mint, Data, PublicKeySize);
+	FMemory::Memcpy(OutAccount.Owner, Data + 32, PublicKeySize);
+	OutAccount.Amount = ReadU64(Data + TokenAmountOffset);
+
+	OutAccount.bHasDelegate = ReadOptionTag(Data + 72);
+	FMemory::Memcpy(OutAccount.Delegate, Data + 76, PublicKeySize);
+
+	OutAccount.State = Data[108];
+
+	OutAccount.bIsNative = ReadOptionTag(Data + 109);
+	OutAccount.NativeReserve = ReadU64(Data + 113);
+
+	OutAccount.DelegatedAmount = ReadU64(Data + 121);
+
+	OutAccount.bHasCloseAuthority = ReadOptionTag(Data + 129);
+	FMemory::Memcpy(OutAccount.CloseAuthority, Data + 133, PublicKeySize);
+	return true;
+}
+
+bool FTokenAccountLayout::DecodeBase64(const FString& Data, FTokenAccountLayout& OutAccount)
+{
+	TArray<uint8> Bytes;
+	return FBase64::Decode(Data, Bytes) && Decode(Bytes.GetData(), Bytes.Num(), OutAccount);
+}
+
+bool FTokenAccountLayout::DecodeMintDecimals(const uint8* Data, int32 Size, bool bSliced, uint8& OutDecimals)
+{
+	const int32 Offset = bSliced ? 0 : MintDecimalsOffset;
+	if( Size <= Offset )
+	{
+		return false;
+	}
+	OutDecimals = Data[Offset];
+	return true;
+}
+
+bool FTokenAccountLayout::DecodeAmount(const uint8* Data, int32 Size, bool bSliced, uint64& OutAmount)
+{
+	const int32 Offset = bSliced ? 0 : TokenAmountOffset;
+	if( Size < Offset + 8 )
+	{
+		return false;
+	}
+	OutAmount = ReadU64(Data + Offset);
+	return true;
+}
+
+FString FTokenAccountLayout::GetMint() const
+{
+	return FBase58::EncodeBase58(Mint, PublicKeySize);
+}
+
+FString FTokenAccountLayout::GetOwner() const
+{
+	return FBase58::EncodeBase58(Owner, PublicKeySize);
+}
+
+double FTokenAccountLayout::GetUIAmount(uint8 Decimals) const
+{
+	return static_cast<double>(Amount) / FMath::Pow(10.0, Decimals);
+}
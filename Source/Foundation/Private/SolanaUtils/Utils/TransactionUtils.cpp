@@ -18,6 +18,7 @@ Author: Jon Sawler
 
 #include "TransactionUtils.h"
 
+#include "ByteWriter.h"
 #include "Crypto/Base58.h"
 #include "Crypto/FEd25519Bip39.h"
 #include "SolanaUtils/Instructions.h"
@@ -39,6 +40,13 @@ TArray<uint8> FTransactionUtils::TransferTokenTransaction(const FAccount& from,
 	FTransaction transaction(blockHash);
 	if(existingAccount.IsEmpty()) 
 	{
+		FPublicKey mintKey;
+		if( !FPublicKey::TryFromBase58(mint, mintKey) )
+		{
+			return TArray<uint8>();
+		}
+
+
 		const FMnemonic mnemonic(24);
 		FEd25519Bip39 keypair(mnemonic.DeriveSeed());
 		const FAccount newKeypair = FAccount::FromSeed(keypair.DeriveAccountPath(0));
@@ -48,14 +56,61 @@ TArray<uint8> FTransactionUtils::TransferTokenTransaction(const FAccount& from,
 		signers.Add(newKeypair);
 		
 		transaction.AddInstruction(FInstruction::CreateAccount(owner, newKeypair, newAccountSize));
-		transaction.AddInstruction(FInstruction::InitializeTokenAccount(newKeypair, FBase58::DecodeBase58(mint), to));
+		transaction.AddInstruction(FInstruction::InitializeTokenAccount(newKeypair, mintKey, to));
 		transaction.AddInstruction(FInstruction::TransferTokens(from, newKeypair, owner, amount));
 	}
 	else
 	{
+		FAccount existing;
+		if( !FAccount::TryFromPublicKey(existingAccount, existing) )
+		{
+			return TArray<uint8>();
+		}
+
 		signers.Add(owner);
-		transaction.AddInstruction(FInstruction::TransferTokens(from, FAccount::FromPublicKey(existingAccount), owner, amount));
+		transaction.AddInstruction(FInstruction::TransferTokens(from, existing, owner, amount));
 	}
 	
 	return transaction.Build(signers);
 }
+
+TArray<FString> FTransactionUtils::GetAccountKeys(const TArray<uint8>& transaction)
+{
+	TArray<FString> keys;
+
+	FByteReader reader(transaction);
+	int32 count = 0;
+	if( !reader.ReadCompactU16(count) || !reader.Skip(count * FSignature::Size) )
+	{
+		return keys;
+	}
+
+	// Versioned messages are prefixed with 0x80 | version ahead of the header.
+	uint8 prefix = 0;
+	if( !reader.ReadU8(prefix) || !reader.Skip((prefix & 0x80) != 0 ? 3 : 2) )
+	{
+		return keys;
+	}
+
+	if( !reader.ReadCompactU16(count) )
+	{
+		return keys;
+	}
+	if( const uint8* accountKeys = reader.Peek(count * FPublicKey::Size) )
+	{
+		FBase58::EncodeMany(accountKeys, count, FPublicKey::Size, keys);
+	}
+	return keys;
+}
+
+FString FTransactionUtils::GetSignature(const TArray<uint8>& transaction)
+{
+	FByteReader reader(transaction);
+	int32 count = 0;
+	FSignature signature;
+	if( !reader.ReadCompactU16(count) || count == 0 || !reader.ReadSignature(signature) )
+	{
+		return FString();
+	}
+	return signature.ToBase58();
+}
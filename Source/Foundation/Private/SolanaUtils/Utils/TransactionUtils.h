@@ -23,6 +23,13 @@ class FTransactionUtils
 {
 public:
 	
+	// Both are empty if the blockhash, mint or existing account is not a valid key.
 	static TArray<uint8> TransferTokenTransaction(const FAccount& from, const FAccount& to, const FAccount& owner, int64 amount, const FString& mint, const FString& blockHash, const FString& existingAccount);
 	static TArray<uint8> TransferSOLTransaction(const FAccount& from, const FAccount& to, int64 amount, const FString& blockHash);
+
+	// Base58 keys of the static accounts referenced by a serialized transaction.
+	static TArray<FString> GetAccountKeys(const TArray<uint8>& transaction);
+
+	// Base58 of the fee payer signature, which identifies a signed transaction. Empty if unsigned or malformed.
+	static FString GetSignature(const TArray<uint8>& transaction);
 };
@@ -19,10 +19,13 @@ Contributers: Daniele Calanna, Federico Arona
 
 #include "SolanaUtils/Wallet.h"
 
+#include "Network/BlockhashProvider.h"
 #include "Network/RequestManager.h"
 #include "JsonObjectConverter.h"
 #include "Network/RequestUtils.h"
+#include "Network/TransactionSender.h"
 #include "Utils/TransactionUtils.h"
+#include "SolanaUtils/Utils/TokenLayout.h"
 #include "SolanaUtils/Utils/Types.h"
 
 UWallet::UWallet()
@@ -37,7 +40,10 @@ UWallet::~UWallet()
 void UWallet::SetPublicKey( const FString& pubKey )
 {
 	PublicKey = pubKey;
-	Account.PublicKey = pubKey;
+	if( !FAccount::TryFromPublicKey(pubKey, Account) )
+	{
+		Account = FAccount();
+	}
 }
 
 bool UWallet::IsValidPublicKey( const FString& pubKey )
@@ -64,7 +70,7 @@ void UWallet::UpdateWalletData()
 {
 	if( IsValidPublicKey(PublicKey) )
 	{
-		FRequestData* request = FRequestUtils::RequestAccountInfo(PublicKey);
+		FRequestData* request = FRequestUtils::RequestAccountInfo(PublicKey, FDataSlice());
 		request->Callback.BindLambda( [this](const FJsonObject& data)
 		{
 			const FAccountInfoJson response = FRequestUtils::ParseAccountInfoResponse(data);
@@ -116,31 +122,76 @@ void UWallet::UpdateAllTokenAccounts()
 {
 	if( IsValidPublicKey(PublicKey) )
 	{
-		FRequestData* request = FRequestUtils::RequestAllTokenAccounts(PublicKey, TokenProgramId);
-		request->Callback.BindLambda([this](const FJsonObject& data)
+		FRequestData* request = FRequestUtils::RequestAllTokenAccounts(PublicKey, TokenProgramId, EAccountEncoding::Base64Zstd);
+		request->BindResult<TArray<FTokenAccountEntry>>(&FRequestUtils::DecodeTokenAccountsResult, [this](const TArray<FTokenAccountEntry>& entries)
 		{
-			TokenAccounts.Empty();
-			if(TSharedPtr<FJsonObject> result = data.GetObjectField("result"))
+			if( entries.IsEmpty() )
 			{
-				FTokenAccountArrayJson jsonData;
-				FJsonObjectConverter::JsonObjectToUStruct(result.ToSharedRef(), &jsonData);
+				TokenAccounts.Empty();
+				return;
+			}
+
+			TArray<FString> mints;
+			for( const FTokenAccountEntry& entry : entries )
+			{
+				mints.Add(entry.Account.GetMint());
+			}
 
-				if(!jsonData.value.IsEmpty())
+			FRequestUtils::FetchMintDecimals(mints, [this, entries, mints](const TMap<FString, uint8>& decimals)
+			{
+				TokenAccounts.Empty();
+				TSet<FString> unknownMints;
+				for( int32 index = 0; index < entries.Num(); index++ )
 				{
-					for( FTokenBalanceDataJson entry: jsonData.value)
+					if( const uint8* mintDecimals = decimals.Find(mints[index]) )
 					{
-						FTokenInfoJson info = entry.account.data.parsed.info;
-
 						FAccountData account;
-						account.Pubkey = entry.pubkey;
-						account.Balance = info.tokenAmount.uiAmount;
-						account.Mint = info.mint;
+						account.Pubkey = entries[index].Pubkey;
+						account.Balance = entries[index].Account.GetUIAmount(*mintDecimals);
+						account.Mint = mints[index];
+						account.Decimals = *mintDecimals;
 
 						TokenAccounts.Add(account);
 					}
+					else
+					{
+						unknownMints.Add(mints[index]);
+					}
+				}
+
+				if( unknownMints.Num() == 0 )
+				{
 					OnAccountsUpdated.Broadcast(this);
+					return;
 				}
-			}
+
+				// Mints whose decimals could not be read fall back to the parsed encoding, which carries them.
+				FRequestData* parsedRequest = FRequestUtils::RequestAllTokenAccounts(PublicKey, TokenProgramId);
+				parsedRequest->BindResult<FTokenAccountArrayJson>(&FRequestUtils::DecodeAllTokenAccountsResult, [this, unknownMints](const FTokenAccountArrayJson& response)
+				{
+					for( const FTokenBalanceDataJson& entry : response.value )
+					{
+						const FTokenInfoJson& info = entry.account.data.parsed.info;
+						if( unknownMints.Contains(info.mint) )
+						{
+							FAccountData account;
+							account.Pubkey = entry.pubkey;
+							account.Balance = info.tokenAmount.uiAmount;
+							account.Mint = info.mint;
+							account.Decimals = static_cast<uint8>(info.tokenAmount.decimals);
+
+							TokenAccounts.Add(account);
+						}
+					}
+					OnAccountsUpdated.Broadcast(this);
+				});
+				parsedRequest->ErrorCallback.BindLambda([this](const FText& failureReason)
+				{
+					FRequestUtils::DisplayError(FString::Printf(TEXT("Some token accounts could not be read: %s"), *failureReason.ToString()));
+					OnAccountsUpdated.Broadcast(this);
+				});
+				FRequestManager::SendRequest(parsedRequest);
+			});
 		});
 		FRequestManager::SendRequest(request);
 	}
@@ -150,44 +201,55 @@ void UWallet::CheckPossibleAccounts(const TArray<FString>& pubKeys)
 {
 	if( IsValidPublicKey(pubKeys) )
 	{
-		FRequestData* request = FRequestUtils::RequestMultipleAccounts(pubKeys);
-		request->Callback.BindLambda([this](const FJsonObject& data)
+		FRequestUtils::FetchMultipleAccounts(pubKeys, [this](const TMap<FString, FAccountInfoJson>& response)
 		{
-			const TArray<FAccountInfoJson> response = FRequestUtils::ParseMultipleAccountsResponse(data);
 			//TODO: stuff?			
 		});
-		FRequestManager::SendRequest(request);
 	}
 }
 
-void UWallet::SendSOL(const FAccount& from, const FAccount& to, int64 amount) const
+// Resend until confirmed and report the outcome.
+static void SendAndConfirm(const TArray<uint8>& transaction, const FBlockhashInfo& blockhash)
 {
-	FRequestData* request = FRequestUtils::RequestBlockHash();
-	request->Callback.BindLambda([this, from, to, amount](const FJsonObject& data)
+	if( transaction.IsEmpty() )
 	{
-		FString blockHash = FRequestUtils::ParseBlockHashResponse(data);
+		FRequestUtils::DisplayError(TEXT("Could not build the transaction"));
+		return;
+	}
 
-		TArray<uint8> tranaction = FTransactionUtils::TransferSOLTransaction(from, to, amount, blockHash);
-		
-		FRequestData* transaction = FRequestUtils::SendTransaction( FBase64::Encode(tranaction));
-		transaction->Callback.BindLambda([this, from, to, amount](const FJsonObject& data)
+	FTransactionSender::Send(transaction, blockhash, TransactionStatusCallback::CreateLambda([](const FString& signature, ETransactionStatus status)
+	{
+		if( status == ETransactionStatus::Confirmed )
 		{
-			FString transactionID = FRequestUtils::ParseTransactionResponse(data);
-			FRequestUtils::DisplayInfo(FString::Printf(TEXT("Transaction Id: %s"), *transactionID));
-		});
-		FRequestManager::SendRequest(transaction);
+			FRequestUtils::DisplayInfo(FString::Printf(TEXT("Transaction Id: %s"), *signature));
+		}
+		else if( status == ETransactionStatus::Expired )
+		{
+			FRequestUtils::DisplayError(FString::Printf(TEXT("Transaction expired before landing: %s"), *signature));
+		}
+	}));
+}
+
+void UWallet::SendSOL(const FAccount& from, const FAccount& to, int64 amount) const
+{
+	FBlockhashProvider::GetBlockhash([this, from, to, amount](const FBlockhashInfo& blockhash)
+	{
+		const TArray<uint8> transaction = FTransactionUtils::TransferSOLTransaction(from, to, amount, blockhash.Blockhash);
+
+		SendAndConfirm(transaction, blockhash);
 	});
-	FRequestManager::SendRequest(request);
 }
 
 void UWallet::SendSOLEstimate(const FAccount& from, const FAccount& to, int64 amount) const
 {
-	FRequestData* request = FRequestUtils::RequestBlockHash();
-	request->Callback.BindLambda([this, from, to, amount](const FJsonObject& data)
+	FBlockhashProvider::GetBlockhash([this, from, to, amount](const FBlockhashInfo& blockhash)
 	{
-		FString blockHash = FRequestUtils::ParseBlockHashResponse(data);
-
-		TArray<uint8> transaction = FTransactionUtils::TransferSOLTransaction(from, to, amount, blockHash);
+		TArray<uint8> transaction = FTransactionUtils::TransferSOLTransaction(from, to, amount, blockhash.Blockhash);
+		if( transaction.IsEmpty() )
+		{
+			FRequestUtils::DisplayError(TEXT("Could not build the transaction"));
+			return;
+		}
 	
 		FRequestData* feeRequest = FRequestUtils::GetTransactionFeeAmount( FBase64::Encode(transaction));
 		feeRequest->Callback.BindLambda([this, from, to, amount](const FJsonObject& data)
@@ -198,23 +260,24 @@ void UWallet::SendSOLEstimate(const FAccount& from, const FAccount& to, int64 am
 		FRequestManager::SendRequest(feeRequest);
 
 	});
-	FRequestManager::SendRequest(request);
 }
 
 void UWallet::SendTokenEstimate(const FAccount& from, const FAccount& to, const FString& mint, int64 amount) const
 {
-	FRequestData* accountRequest = FRequestUtils::RequestTokenAccount(to.PublicKey, mint);
+	FRequestData* accountRequest = FRequestUtils::RequestTokenAccount(to.GetPublicKey(), mint);
 	accountRequest->Callback.BindLambda([this, from, to, amount, mint](const FJsonObject& data)
 	{
 		FString existingAccount = FRequestUtils::ParseTokenAccountResponse(data);
 		if(!existingAccount.IsEmpty())
 		{
-			FRequestData* blockhashRequest = FRequestUtils::RequestBlockHash();
-			blockhashRequest->Callback.BindLambda([this, from, to, amount, mint, existingAccount](const FJsonObject& data)
+			FBlockhashProvider::GetBlockhash([this, from, to, amount, mint, existingAccount](const FBlockhashInfo& blockhash)
 			{
-				FString blockHash = FRequestUtils::ParseBlockHashResponse(data);
-
-				const TArray<uint8> transaction = FTransactionUtils::TransferTokenTransaction(from, to, Account, amount, mint, blockHash, existingAccount);
+				const TArray<uint8> transaction = FTransactionUtils::TransferTokenTransaction(from, to, Account, amount, mint, blockhash.Blockhash, existingAccount);
+				if( transaction.IsEmpty() )
+				{
+					FRequestUtils::DisplayError(TEXT("Could not build the transaction"));
+					return;
+				}
 
 				FRequestData* sendTransaction = FRequestUtils::GetTransactionFeeAmount(FBase64::Encode(transaction));
 				sendTransaction->Callback.BindLambda([this](FJsonObject& data)
@@ -224,7 +287,6 @@ void UWallet::SendTokenEstimate(const FAccount& from, const FAccount& to, const
 				});
 				FRequestManager::SendRequest(sendTransaction);
 			});
-			FRequestManager::SendRequest(blockhashRequest);
 		}
 	});
 	FRequestManager::SendRequest(accountRequest);
@@ -232,28 +294,18 @@ void UWallet::SendTokenEstimate(const FAccount& from, const FAccount& to, const
 
 void UWallet::SendToken(const FAccount& from, const FAccount& to, const FString& mint, int64 amount) const
 {
-	FRequestData* accountRequest = FRequestUtils::RequestTokenAccount(to.PublicKey, mint);
+	FRequestData* accountRequest = FRequestUtils::RequestTokenAccount(to.GetPublicKey(), mint);
 	accountRequest->Callback.BindLambda([this, from, to, amount, mint](const FJsonObject& data)
 	{
 		FString existingAccount = FRequestUtils::ParseTokenAccountResponse(data);
 		if(!existingAccount.IsEmpty())
 		{
-			FRequestData* blockhashRequest = FRequestUtils::RequestBlockHash();
-			blockhashRequest->Callback.BindLambda([this, from, to, amount, mint, existingAccount](FJsonObject& data)
+			FBlockhashProvider::GetBlockhash([this, from, to, amount, mint, existingAccount](const FBlockhashInfo& blockhash)
 			{
-				FString blockHash = FRequestUtils::ParseBlockHashResponse(data);
-
-				const TArray<uint8> transaction = FTransactionUtils::TransferTokenTransaction(from, to, Account, amount, mint, blockHash, existingAccount);
+				const TArray<uint8> transaction = FTransactionUtils::TransferTokenTransaction(from, to, Account, amount, mint, blockhash.Blockhash, existingAccount);
 
-				FRequestData* sendTransaction = FRequestUtils::SendTransaction(FBase64::Encode(transaction));
-				sendTransaction->Callback.BindLambda([this](FJsonObject& data)
-				{
-					const FString transactionID = FRequestUtils::ParseTransactionResponse(data);
-					FRequestUtils::DisplayInfo(FString::Printf(TEXT("Transaction Id: %s"), *transactionID));
-				});
-				FRequestManager::SendRequest(sendTransaction);
+				SendAndConfirm(transaction, blockhash);
 			});
-			FRequestManager::SendRequest(blockhashRequest);
 		}
 	});
 	FRequestManager::SendRequest(accountRequest);
@@ -29,12 +29,15 @@ Contributers: Riccardo Torrisi, Federico Arona
 #include "WalletAccount.h"
 #include "Network/RequestManager.h"
 #include "Network/RequestUtils.h"
+#include "Network/SolanaRpcClient.h"
 #include "SolanaUtils/Account.h"
 
 #if PLATFORM_WINDOWS
 #include "Windows/WindowsPlatformApplicationMisc.h"
 #endif
 
+DECLARE_LOG_CATEGORY_CLASS(SolanaWallet, Log, All);
+
 TArray<uint32> FDerivationPath::GetDerivationPathSegments(uint32 Index)
 {
 	TArray<uint32> Result = Segments;
@@ -90,9 +93,15 @@ bool USolanaWallet::SetSaveSlotName(FString NewSaveSlotName)
 		PublicKeys = SaveData->PublicKeys;
 		for (const auto& PublicKey : PublicKeys)
 		{
+			FAccount AccountData;
+			if (!FAccount::TryFromPublicKey(PublicKey, AccountData))
+			{
+				UE_LOG(SolanaWallet, Warning, TEXT("Skipping invalid saved public key %s"), *PublicKey);
+				continue;
+			}
 			UWalletAccount* Account = NewObject<UWalletAccount>(this);
-			Account->AccountData.PublicKey = PublicKey;
-			Accounts.Add(PublicKey, Account);
+			Account->AccountData = MoveTemp(AccountData);
+			Accounts.Add(Account->AccountData.PublicKeyData, Account);
 		}
 	}
 	return true;
@@ -187,6 +196,7 @@ bool USolanaWallet::SaveWallet()
 	CurrentSaveData->Accounts.Empty();
 	for (auto& [PublicKey, Account] : Accounts)
 	{
+		// Only the base58 keys are saved.
 		CurrentSaveData->Accounts.Add(Account->AccountData);
 	}
 
@@ -252,7 +262,7 @@ bool USolanaWallet::UnlockWallet(FString Password, FText& FailReason)
 	for (int32 i = 0; i < CurrentSaveData->Accounts.Num(); ++i)
 	{
 		const FAccount& AccountData = CurrentSaveData->Accounts[i];
-		const FString& PublicKey = AccountData.PublicKey;
+		const FPublicKey& PublicKey = AccountData.PublicKeyData;
 		UWalletAccount* Account;
 		if (UWalletAccount* const* AccountPtr = Accounts.Find(PublicKey))
 		{
@@ -264,7 +274,7 @@ bool USolanaWallet::UnlockWallet(FString Password, FText& FailReason)
 			Accounts.Add(PublicKey, Account);
 		}
 		Account->AccountData = AccountData;
-		PublicKeys.Add(Account->AccountData.PublicKey);
+		PublicKeys.Add(Account->AccountData.GetPublicKey());
 	}
 
 	Mnemonic = WalletSaveData->Mnemonic;
@@ -385,8 +395,8 @@ UWalletAccount* USolanaWallet::GenerateAccountFromGenIndex(int32 GenIndex)
 	AccountData.Name = FString::Printf(TEXT("Wallet %i"), Accounts.Num() + 1);
 	AccountData.GenIndex = GenIndex;
 	Account->AccountData = AccountData;
-	Accounts.Add(AccountData.PublicKey, Account);
-	PublicKeys.Add(Account->AccountData.PublicKey);
+	Accounts.Add(AccountData.PublicKeyData, Account);
+	PublicKeys.Add(Account->AccountData.GetPublicKey());
 	return Account;
 }
 
@@ -438,17 +448,24 @@ UWalletAccount* USolanaWallet::ImportAccountFromPrivateKey(FString PrivateKey)
 	{
 		Account->AccountData = FAccount::FromPrivateKey(PrivateKey);
 	}
-	
-	Accounts.Add(Account->AccountData.PublicKey, Account);
-	PublicKeys.Add(Account->AccountData.PublicKey);
+
+	Accounts.Add(Account->AccountData.PublicKeyData, Account);
+	PublicKeys.Add(Account->AccountData.GetPublicKey());
 	return Account;
 }
 
 UWalletAccount* USolanaWallet::ImportAccountFromPublicKey(FString PublicKey)
 {
+	FAccount AccountData;
+	if (!FAccount::TryFromPublicKey(PublicKey, AccountData))
+	{
+		FRequestUtils::DisplayError(FString::Printf(TEXT("Invalid public key: %s"), *PublicKey));
+		return nullptr;
+	}
+
 	UWalletAccount* Account = NewObject<UWalletAccount>(this);
-	Account->AccountData = FAccount::FromPublicKey(PublicKey);
-	Accounts.Add(PublicKey, Account);
+	Account->AccountData = MoveTemp(AccountData);
+	Accounts.Add(Account->AccountData.PublicKeyData, Account);
 	PublicKeys.Add(PublicKey);
 	return Account;
 }
@@ -460,8 +477,8 @@ void USolanaWallet::RemoveAccount(UWalletAccount* Account)
 		return;
 	}
 	
-	Accounts.Remove(Account->AccountData.PublicKey);
-	PublicKeys.Remove(Account->AccountData.PublicKey);
+	Accounts.Remove(Account->AccountData.PublicKeyData);
+	PublicKeys.Remove(Account->AccountData.GetPublicKey());
 }
 
 void USolanaWallet::RemoveAllAccounts()
@@ -493,7 +510,12 @@ int32 USolanaWallet::GetAccountsCount() const
 
 UWalletAccount* USolanaWallet::GetAccountFromPublicKey(FString PublicKey) const
 {
-	if (UWalletAccount* const* AccountPtr = Accounts.Find(PublicKey))
+	FPublicKey Key;
+	if (!FPublicKey::TryFromBase58(PublicKey, Key))
+	{
+		return nullptr;
+	}
+	if (UWalletAccount* const* AccountPtr = Accounts.Find(Key))
 	{
 		return *AccountPtr;
 	}
@@ -507,19 +529,24 @@ void USolanaWallet::UpdateAccounts()
     	return;
     }
 
-	FRequestData* Request = FRequestUtils::RequestMultipleAccounts(GetPublicKeys());
-	TArray<UWalletAccount*> CurrentAccounts = GetAccounts();
-	Request->Callback.BindLambda([this, CurrentAccounts](const FJsonObject& JsonResponse)
+	FRequestPriorityScope PriorityScope(GetRpcClient(), ERequestPriority::Background);
+	FRequestUtils::FetchMultipleAccounts(GetPublicKeys(), [this](const TMap<FString, FAccountInfoJson>& Response)
 	{
-		const TArray<FAccountInfoJson> Response = FRequestUtils::ParseMultipleAccountsResponse(JsonResponse);
-		for (int32 Index = 0; Index < Response.Num(); ++Index)
+		// Accounts may have been added or removed while the request was in flight, so match by key.
+		for (auto& [PublicKey, Account] : Accounts)
 		{
-			const FAccountInfoJson& AccountInfoJson = Response[Index];
-			CurrentAccounts[Index]->UpdateFromAccountInfoJson(AccountInfoJson);
+			if (const FAccountInfoJson* AccountInfo = Response.Find(Account->AccountData.GetPublicKey()))
+			{
+				Account->UpdateFromAccountInfoJson(*AccountInfo);
+			}
 		}
 		OnAccountsUpdated.Broadcast();
-	});
-	FRequestManager::SendRequest(Request);
+	}, nullptr, GetRpcClient());
+}
+
+TSharedRef<FSolanaRpcClient> USolanaWallet::GetRpcClient() const
+{
+	return RpcClient.IsValid() ? RpcClient.ToSharedRef() : FRequestManager::GetDefaultClient();
 }
 
 void USolanaWallet::UpdateTokenAccounts()
@@ -529,12 +556,22 @@ void USolanaWallet::UpdateTokenAccounts()
 		return;
 	}
 
+	FRequestBatchScope BatchScope(GetRpcClient());
+	FRequestPriorityScope PriorityScope(GetRpcClient(), ERequestPriority::Background);
 	for (UWalletAccount* Account : GetAccounts())
 	{
 		Account->UpdateTokenAccounts();
 	}
 }
 
+void USolanaWallet::SetLiveUpdates(bool bEnabled)
+{
+	for (UWalletAccount* Account : GetAccounts())
+	{
+		Account->SetLiveUpdates(bEnabled);
+	}
+}
+
 void USolanaWallet::ClipboardCopy(FString String)
 {
 #if PLATFORM_WINDOWS
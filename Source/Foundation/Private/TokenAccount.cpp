@@ -19,26 +19,30 @@ Contributers: Riccardo Torrisi, Federico Arona
 
 #include "TokenAccount.h"
 
-#include "JsonObjectConverter.h"
 #include "WalletAccount.h"
 #include "Network/RequestManager.h"
 #include "Network/RequestUtils.h"
+#include "Network/SolanaRpcClient.h"
+#include "Network/SubscriptionManager.h"
+#include "SolanaUtils/Utils/TokenLayout.h"
 
 void UTokenAccount::Update()
 {
-	FRequestData* accountRequest = FRequestUtils::RequestTokenAccount(AccountData.Pubkey, AccountData.Mint);
-	accountRequest->Callback.BindLambda([this](FJsonObject& data)
+	// Only the eight bytes of the amount are downloaded.
+	FRequestData* accountRequest = FRequestUtils::RequestAccountInfo(AccountData.Pubkey, FDataSlice{ TokenAmountOffset, 8 });
+	accountRequest->BindResult<TOptional<FAccountInfoJson>>(&FRequestUtils::DecodeAccountInfoResult, [WeakThis = TWeakObjectPtr<UTokenAccount>(this)](const TOptional<FAccountInfoJson>& info)
 	{
-		if(TSharedPtr<FJsonObject> result = data.GetObjectField("result"))
+		UTokenAccount* TokenAccount = WeakThis.Get();
+		TConstArrayView<uint8> bytes;
+		uint64 amount;
+		if( TokenAccount && info.IsSet() && info->data.Num() >= 2 && FRequestUtils::DecodeAccountData(info->data[0], info->data[1], bytes)
+			&& FTokenAccountLayout::DecodeAmount(bytes.GetData(), bytes.Num(), true, amount) )
 		{
-			FTokenBalanceDataJson jsonData;
-			FJsonObjectConverter::JsonObjectToUStruct(result.ToSharedRef(), &jsonData);
-
-			FTokenInfoJson info = jsonData.account.data.parsed.info;
-			AccountData.Balance = info.tokenAmount.uiAmount;
-			OnBalanceUpdated.Broadcast(this, AccountData.Balance);
+			TokenAccount->AccountData.Balance = static_cast<double>(amount) / FMath::Pow(10.0, TokenAccount->AccountData.Decimals);
+			TokenAccount->OnBalanceUpdated.Broadcast(TokenAccount, TokenAccount->AccountData.Balance);
 		}
 	});
+	CastChecked<UWalletAccount>(GetOuter())->GetOwningWallet()->GetRpcClient()->SendRequest(accountRequest);
 }
 
 void UTokenAccount::Send(FString RecipientPublicKey, float Amount)
@@ -46,3 +50,37 @@ void UTokenAccount::Send(FString RecipientPublicKey, float Amount)
 	UWalletAccount* WalletAccountOwner = Cast<UWalletAccount>(GetOuter());
 	WalletAccountOwner->SendToken(this, RecipientPublicKey, Amount);
 }
+
+void UTokenAccount::SetLiveUpdates(bool bEnabled)
+{
+	if( bEnabled == HasLiveUpdates() )
+	{
+		return;
+	}
+
+	if( !bEnabled )
+	{
+		FSubscriptionManager::Unsubscribe(Subscription);
+		Subscription = 0;
+		return;
+	}
+
+	SubscriptionCallback Callback;
+	Callback.BindWeakLambda(this, [this](const FJsonObject& Result)
+	{
+		const TSharedPtr<FJsonObject>* Value;
+		FTokenAccountLayout Layout;
+		if( Result.TryGetObjectField("value", Value) && FRequestUtils::ParseTokenAccountData(**Value, Layout) )
+		{
+			AccountData.Balance = Layout.GetUIAmount(AccountData.Decimals);
+			OnBalanceUpdated.Broadcast(this, AccountData.Balance);
+		}
+	});
+	Subscription = FSubscriptionManager::SubscribeAccount(AccountData.Pubkey, Callback);
+}
+
+void UTokenAccount::BeginDestroy()
+{
+	SetLiveUpdates(false);
+	Super::BeginDestroy();
+}
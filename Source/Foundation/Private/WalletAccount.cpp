@@ -21,10 +21,18 @@ Contributers: Riccardo Torrisi, Federico Arona
 
 #include "JsonObjectConverter.h"
 #include "TokenAccount.h"
+#include "Network/BlockhashProvider.h"
+#include "Network/RequestCache.h"
 #include "Network/RequestManager.h"
 #include "Network/RequestUtils.h"
+#include "Network/SolanaRpcClient.h"
+#include "Network/SubscriptionManager.h"
+#include "Network/TransactionSender.h"
+#include "SolanaUtils/Utils/TokenLayout.h"
 #include "SolanaUtils/Utils/TransactionUtils.h"
 
+DECLARE_LOG_CATEGORY_CLASS(WalletAccount, Log, All);
+
 void UWalletAccount::SetAccountName(const FString& Name)
 {
 	if (AccountData.Name != Name)
@@ -36,53 +44,63 @@ void UWalletAccount::SetAccountName(const FString& Name)
 
 void UWalletAccount::Update()
 {
+	FRequestBatchScope BatchScope(GetOwningWallet()->GetRpcClient());
 	UpdateData();
 	UpdateTokenAccounts();
 }
 
 void UWalletAccount::UpdateData()
 {
-	FRequestData* request = FRequestUtils::RequestAccountInfo(AccountData.PublicKey);
+	FRequestData* request = FRequestUtils::RequestAccountInfo(AccountData.GetPublicKey(), FDataSlice());
 	request->Callback.BindLambda( [this](FJsonObject& data)
 	{
 		const FAccountInfoJson response = FRequestUtils::ParseAccountInfoResponse(data);
 		UpdateFromAccountInfoJson(response);
 	});
-	FRequestManager::SendRequest(request);
+	GetOwningWallet()->GetRpcClient()->SendRequest(request);
 }
 
 void UWalletAccount::UpdateTokenAccounts()
 {
-	FRequestData* request = FRequestUtils::RequestAllTokenAccounts(AccountData.PublicKey, "TokenkegQfeZyiNwAJbNbGKPFXCWuBvf9Ss623VQ5DA");
-	request->Callback.BindLambda([this](FJsonObject& data)
+	FRequestData* request = FRequestUtils::RequestAllTokenAccounts(AccountData.GetPublicKey(), TokenProgramId, EAccountEncoding::Base64Zstd);
+	request->BindResult<TArray<FTokenAccountEntry>>(&FRequestUtils::DecodeTokenAccountsResult, [this](const TArray<FTokenAccountEntry>& entries)
 	{
-		TokenAccounts.Empty();
-		if(TSharedPtr<FJsonObject> result = data.GetObjectField("result"))
+		// The raw layout only carries base units, so balances wait on the decimals of each mint.
+		TArray<FString> mints;
+		for( const FTokenAccountEntry& entry : entries )
 		{
-			FTokenAccountArrayJson jsonData;
-			FJsonObjectConverter::JsonObjectToUStruct(result.ToSharedRef(), &jsonData);
+			mints.Add(entry.Account.GetMint());
+		}
 
-			if(!jsonData.value.IsEmpty())
+		FRequestUtils::FetchMintDecimals(mints, [this, entries, mints](const TMap<FString, uint8>& decimals)
+		{
+			TokenAccounts.Empty();
+			TSet<FString> unknownMints;
+			for( int32 index = 0; index < entries.Num(); index++ )
 			{
-				for( FTokenBalanceDataJson entry: jsonData.value)
+				const uint8* mintDecimals = decimals.Find(mints[index]);
+				if( mintDecimals )
 				{
-					FTokenInfoJson info = entry.account.data.parsed.info;
-
-					UTokenAccount* TokenAccount = TokenAccounts.Contains(info.mint)? TokenAccounts[info.mint] : NewObject<UTokenAccount>(this);
-					TokenAccounts.Add(info.mint, TokenAccount);
-					FAccountData& account = TokenAccount->AccountData;
-					account.Pubkey = entry.pubkey;
-					account.Balance = info.tokenAmount.uiAmount;
-					account.Mint = info.mint;
-					TokenAccount->OnBalanceUpdated.Broadcast(TokenAccount, account.Balance);
-					OnTokenAccountAdded.Broadcast(this, TokenAccount);
+					UpdateTokenAccount(entries[index].Pubkey, mints[index], entries[index].Account.GetUIAmount(*mintDecimals), *mintDecimals);
+				}
+				else
+				{
+					unknownMints.Add(mints[index]);
 				}
 			}
 
+			if( unknownMints.Num() > 0 )
+			{
+				UpdateParsedTokenAccounts(unknownMints, [this]()
+				{
+					OnTokenAccountReceived.Broadcast();
+				});
+				return;
+			}
 			OnTokenAccountReceived.Broadcast();
-		}
+		}, GetOwningWallet()->GetRpcClient());
 	});
-	FRequestManager::SendRequest(request);
+	GetOwningWallet()->GetRpcClient()->SendRequest(request);
 }
 
 void UWalletAccount::UpdateFromAccountInfoJson(const FAccountInfoJson& AccountInfoJson)
@@ -91,34 +109,181 @@ void UWalletAccount::UpdateFromAccountInfoJson(const FAccountInfoJson& AccountIn
 	OnSolBalanceChanged.Broadcast(this, GetSolBalance());
 }
 
-void UWalletAccount::SendSOL(const FAccount& from, const FAccount& to, int64 amount) const
+void UWalletAccount::UpdateTokenAccountFromLayout(const FString& Pubkey, const FTokenAccountLayout& Layout)
 {
-	FRequestData* request = FRequestUtils::RequestBlockHash();
-	request->Callback.BindLambda([this, from, to, amount](FJsonObject& data)
+	const FString Mint = Layout.GetMint();
+	if( const UTokenAccount* TokenAccount = TokenAccounts.FindRef(Mint) )
+	{
+		UpdateTokenAccount(Pubkey, Mint, Layout.GetUIAmount(TokenAccount->AccountData.Decimals), TokenAccount->AccountData.Decimals);
+		return;
+	}
+
+	// First sight of this mint, its decimals are fetched once and cached from then on.
+	FRequestUtils::FetchMintDecimals({ Mint }, [WeakThis = TWeakObjectPtr<UWalletAccount>(this), Pubkey, Mint, Layout](const TMap<FString, uint8>& Decimals)
 	{
-		FString blockHash = FRequestUtils::ParseBlockHashResponse(data);
+		if( !WeakThis.IsValid() )
+		{
+			return;
+		}
+
+		if( const uint8* MintDecimals = Decimals.Find(Mint) )
+		{
+			WeakThis->UpdateTokenAccount(Pubkey, Mint, Layout.GetUIAmount(*MintDecimals), *MintDecimals);
+		}
+		else
+		{
+			WeakThis->UpdateParsedTokenAccounts({ Mint }, nullptr);
+		}
+	}, GetOwningWallet()->GetRpcClient());
+}
 
-		TArray<uint8> tranaction = FTransactionUtils::TransferSOLTransaction(from, to, amount, blockHash);
+void UWalletAccount::UpdateParsedTokenAccounts(const TSet<FString>& Mints, TFunction<void()> OnComplete)
+{
+	UE_LOG(WalletAccount, Log, TEXT("Decimals of %d mints unavailable, reading their token accounts parsed"), Mints.Num());
 
-		FRequestData* transaction = FRequestUtils::SendTransaction( FBase64::Encode(tranaction));
-		transaction->Callback.BindLambda([this, from, to, amount](FJsonObject& data)
+	// The parsed encoding carries the decimals along with the balance, at the cost of a larger response.
+	FRequestData* Request = FRequestUtils::RequestAllTokenAccounts(AccountData.GetPublicKey(), TokenProgramId);
+	Request->BindResult<FTokenAccountArrayJson>(&FRequestUtils::DecodeAllTokenAccountsResult, [WeakThis = TWeakObjectPtr<UWalletAccount>(this), Mints, OnComplete](const FTokenAccountArrayJson& Response)
+	{
+		if( !WeakThis.IsValid() )
 		{
-			FString transactionID = FRequestUtils::ParseTransactionResponse(data);
-			FRequestUtils::DisplayInfo(FString::Printf(TEXT("Transaction Id: %s"), *transactionID));
-		});
-		FRequestManager::SendRequest(transaction);
+			return;
+		}
+
+		for( const FTokenBalanceDataJson& Entry : Response.value )
+		{
+			const FTokenInfoJson& Info = Entry.account.data.parsed.info;
+			if( Mints.Contains(Info.mint) )
+			{
+				WeakThis->UpdateTokenAccount(Entry.pubkey, Info.mint, Info.tokenAmount.uiAmount, static_cast<uint8>(Info.tokenAmount.decimals));
+			}
+		}
+		if( OnComplete )
+		{
+			OnComplete();
+		}
+	});
+	Request->ErrorCallback.BindWeakLambda(this, [Mints, OnComplete](const FText& FailureReason)
+	{
+		UE_LOG(WalletAccount, Warning, TEXT("Token accounts of %d mints left out: %s"), Mints.Num(), *FailureReason.ToString());
+		if( OnComplete )
+		{
+			OnComplete();
+		}
 	});
-	FRequestManager::SendRequest(request);
+	GetOwningWallet()->GetRpcClient()->SendRequest(Request);
 }
 
-void UWalletAccount::SendSOLEstimate(const FAccount& from, const FAccount& to, int64 amount) const
+void UWalletAccount::UpdateTokenAccount(const FString& Pubkey, const FString& Mint, double Balance, uint8 Decimals)
 {
-	FRequestData* request = FRequestUtils::RequestBlockHash();
-	request->Callback.BindLambda([this, from, to, amount](FJsonObject& data)
+	UTokenAccount* TokenAccount = TokenAccounts.FindRef(Mint);
+	const bool bAdded = TokenAccount == nullptr;
+	if( bAdded )
 	{
-		FString blockHash = FRequestUtils::ParseBlockHashResponse(data);
+		TokenAccount = NewObject<UTokenAccount>(this);
+		TokenAccounts.Add(Mint, TokenAccount);
+	}
 
-		TArray<uint8> transaction = FTransactionUtils::TransferSOLTransaction(from, to, amount, blockHash);
+	FAccountData& account = TokenAccount->AccountData;
+	account.Pubkey = Pubkey;
+	account.Balance = Balance;
+	account.Mint = Mint;
+	account.Decimals = Decimals;
+	TokenAccount->OnBalanceUpdated.Broadcast(TokenAccount, account.Balance);
+
+	if( bAdded )
+	{
+		OnTokenAccountAdded.Broadcast(this, TokenAccount);
+	}
+}
+
+void UWalletAccount::SetLiveUpdates(bool bEnabled)
+{
+	if( bEnabled == HasLiveUpdates() )
+	{
+		return;
+	}
+
+	if( !bEnabled )
+	{
+		FSubscriptionManager::Unsubscribe(AccountSubscription);
+		FSubscriptionManager::Unsubscribe(TokenAccountsSubscription);
+		AccountSubscription = 0;
+		TokenAccountsSubscription = 0;
+		return;
+	}
+
+	SubscriptionCallback AccountCallback;
+	AccountCallback.BindWeakLambda(this, [this](const FJsonObject& Result)
+	{
+		InvalidateCachedReads(Result);
+
+		const TSharedPtr<FJsonObject>* Value;
+		FAccountInfoJson AccountInfoJson;
+		if( Result.TryGetObjectField("value", Value) && FJsonObjectConverter::JsonObjectToUStruct((*Value).ToSharedRef(), &AccountInfoJson) )
+		{
+			UpdateFromAccountInfoJson(AccountInfoJson);
+		}
+	});
+	AccountSubscription = FSubscriptionManager::SubscribeAccount(AccountData.GetPublicKey(), AccountCallback);
+
+	// One program subscription covers every token account owned by this key, including ones created later.
+	SubscriptionCallback TokenAccountsCallback;
+	TokenAccountsCallback.BindWeakLambda(this, [this](const FJsonObject& Result)
+	{
+		InvalidateCachedReads(Result);
+
+		const TSharedPtr<FJsonObject>* Value;
+		const TSharedPtr<FJsonObject>* Account;
+		FString Pubkey;
+		FTokenAccountLayout Layout;
+		if( Result.TryGetObjectField("value", Value) && (*Value)->TryGetStringField("pubkey", Pubkey) && (*Value)->TryGetObjectField("account", Account)
+			&& FRequestUtils::ParseTokenAccountData(**Account, Layout) )
+		{
+			UpdateTokenAccountFromLayout(Pubkey, Layout);
+		}
+	});
+	const FString Filters = FString::Printf(TEXT(R"([{"dataSize":%d},{"memcmp":{"offset":32,"bytes":"%s"}}])"), AccountDataSize, *AccountData.GetPublicKey());
+	TokenAccountsSubscription = FSubscriptionManager::SubscribeProgram(TokenProgramId, Filters, TokenAccountsCallback);
+}
+
+void UWalletAccount::InvalidateCachedReads(const FJsonObject& Notification) const
+{
+	// Token account reads are keyed by owner, so any push for this wallet retires them up to the pushed slot.
+	const TSharedPtr<FJsonObject>* Context;
+	double Slot = 0;
+	if( Notification.TryGetObjectField("context", Context) )
+	{
+		(*Context)->TryGetNumberField("slot", Slot);
+	}
+	FRequestCache::Invalidate(AccountData.GetPublicKey(), static_cast<uint64>(Slot));
+}
+
+void UWalletAccount::BeginDestroy()
+{
+	SetLiveUpdates(false);
+	Super::BeginDestroy();
+}
+
+void UWalletAccount::SendSOL(const FAccount& from, const FAccount& to, int64 amount) const
+{
+	FBlockhashProvider::GetBlockhash([this, from, to, amount](const FBlockhashInfo& blockhash)
+	{
+		const TArray<uint8> transaction = FTransactionUtils::TransferSOLTransaction(from, to, amount, blockhash.Blockhash);
+		SendTransaction(transaction, blockhash);
+	}, GetOwningWallet()->GetRpcClient());
+}
+
+void UWalletAccount::SendSOLEstimate(const FAccount& from, const FAccount& to, int64 amount) const
+{
+	FBlockhashProvider::GetBlockhash([this, from, to, amount](const FBlockhashInfo& blockhash)
+	{
+		TArray<uint8> transaction = FTransactionUtils::TransferSOLTransaction(from, to, amount, blockhash.Blockhash);
+		if( transaction.IsEmpty() )
+		{
+			FRequestUtils::DisplayError(TEXT("Could not build the transaction"));
+			return;
+		}
 	
 		FRequestData* feeRequest = FRequestUtils::GetTransactionFeeAmount( FBase64::Encode(transaction));
 		feeRequest->Callback.BindLambda([this, from, to, amount](FJsonObject& data)
@@ -126,16 +291,19 @@ void UWalletAccount::SendSOLEstimate(const FAccount& from, const FAccount& to, i
 			int fee = FRequestUtils::ParseTransactionFeeAmountResponse(data);
 			FRequestUtils::DisplayInfo(FString::Printf(TEXT("Estimate Id: %i"), fee));
 		});
-		FRequestManager::SendRequest(feeRequest);
-
-	});
-	FRequestManager::SendRequest(request);
+		GetOwningWallet()->GetRpcClient()->SendRequest(feeRequest);
+	}, GetOwningWallet()->GetRpcClient());
 }
 
 void UWalletAccount::SendToken(UTokenAccount* TokenAccount, const FString& RecipientPublicKey, float Amount)
 {
 	const FAccountData& TokenAccountData = TokenAccount->AccountData;
-	FAccount RecipientAccount = FAccount::FromPublicKey(RecipientPublicKey);
+	FAccount RecipientAccount;
+	if( !FAccount::TryFromPublicKey(RecipientPublicKey, RecipientAccount) )
+	{
+		FRequestUtils::DisplayError(FString::Printf(TEXT("Invalid recipient address: %s"), *RecipientPublicKey));
+		return;
+	}
 	
 	FRequestData* accountRequest = FRequestUtils::RequestTokenAccount(TokenAccountData.Pubkey, TokenAccountData.Mint);
 	accountRequest->Callback.BindLambda([this, TokenAccountData, RecipientAccount, Amount](FJsonObject& data)
@@ -143,31 +311,25 @@ void UWalletAccount::SendToken(UTokenAccount* TokenAccount, const FString& Recip
 		FString existingAccount = FRequestUtils::ParseTokenAccountResponse(data);
 		if(!existingAccount.IsEmpty())
 		{
-			FRequestData* blockhashRequest = FRequestUtils::RequestBlockHash();
-			blockhashRequest->Callback.BindLambda([this, TokenAccountData, RecipientAccount, Amount, existingAccount](FJsonObject& data)
+			FBlockhashProvider::GetBlockhash([this, TokenAccountData, RecipientAccount, Amount, existingAccount](const FBlockhashInfo& blockhash)
 			{
-				FString blockHash = FRequestUtils::ParseBlockHashResponse(data);
-
-				const TArray<uint8> transaction = FTransactionUtils::TransferTokenTransaction(AccountData, RecipientAccount, AccountData, Amount, TokenAccountData.Mint, blockHash, existingAccount);
-
-				FRequestData* sendTransaction = FRequestUtils::SendTransaction(FBase64::Encode(transaction));
-				sendTransaction->Callback.BindLambda([this](FJsonObject& data)
-				{
-					const FString transactionID = FRequestUtils::ParseTransactionResponse(data);
-					FRequestUtils::DisplayInfo(FString::Printf(TEXT("Transaction Id: %s"), *transactionID));
-				});
-				FRequestManager::SendRequest(sendTransaction);
-			});
-			FRequestManager::SendRequest(blockhashRequest);
+				const TArray<uint8> transaction = FTransactionUtils::TransferTokenTransaction(AccountData, RecipientAccount, AccountData, Amount, TokenAccountData.Mint, blockhash.Blockhash, existingAccount);
+				SendTransaction(transaction, blockhash);
+			}, GetOwningWallet()->GetRpcClient());
 		}
 	});
-	FRequestManager::SendRequest(accountRequest);
+	GetOwningWallet()->GetRpcClient()->SendRequest(accountRequest);
 }
 
 void UWalletAccount::SendTokenEstimate(UTokenAccount* TokenAccount, const FString& RecipientPublicKey, float Amount) const
 {
 	const FAccountData& TokenAccountData = TokenAccount->AccountData;
-	FAccount RecipientAccount = FAccount::FromPublicKey(RecipientPublicKey);
+	FAccount RecipientAccount;
+	if( !FAccount::TryFromPublicKey(RecipientPublicKey, RecipientAccount) )
+	{
+		FRequestUtils::DisplayError(FString::Printf(TEXT("Invalid recipient address: %s"), *RecipientPublicKey));
+		return;
+	}
 	
 	FRequestData* accountRequest = FRequestUtils::RequestTokenAccount(TokenAccountData.Pubkey, TokenAccountData.Mint);
 	accountRequest->Callback.BindLambda([this, TokenAccountData, RecipientAccount, Amount](FJsonObject& data)
@@ -175,11 +337,14 @@ void UWalletAccount::SendTokenEstimate(UTokenAccount* TokenAccount, const FStrin
 		FString existingAccount = FRequestUtils::ParseTokenAccountResponse(data);
 		if(!existingAccount.IsEmpty())
 		{
-			FRequestData* blockhashRequest = FRequestUtils::RequestBlockHash();
-			blockhashRequest->Callback.BindLambda([this, TokenAccountData, RecipientAccount, Amount, existingAccount](FJsonObject& data)
+			FBlockhashProvider::GetBlockhash([this, TokenAccountData, RecipientAccount, Amount, existingAccount](const FBlockhashInfo& blockhash)
 			{
-				FString blockHash = FRequestUtils::ParseBlockHashResponse(data);
-				const TArray<uint8> transaction = FTransactionUtils::TransferTokenTransaction(AccountData, RecipientAccount, AccountData, Amount, TokenAccountData.Mint, blockHash, existingAccount);
+				const TArray<uint8> transaction = FTransactionUtils::TransferTokenTransaction(AccountData, RecipientAccount, AccountData, Amount, TokenAccountData.Mint, blockhash.Blockhash, existingAccount);
+				if( transaction.IsEmpty() )
+				{
+					FRequestUtils::DisplayError(TEXT("Could not build the transaction"));
+					return;
+				}
 
 				FRequestData* sendTransaction = FRequestUtils::GetTransactionFeeAmount(FBase64::Encode(transaction));
 				sendTransaction->Callback.BindLambda([this](FJsonObject& data)
@@ -187,15 +352,42 @@ void UWalletAccount::SendTokenEstimate(UTokenAccount* TokenAccount, const FStrin
 					int fee = FRequestUtils::ParseTransactionFeeAmountResponse(data);
 					FRequestUtils::DisplayInfo(FString::Printf(TEXT("Estimate Id: %i"), fee));
 				});
-				FRequestManager::SendRequest(sendTransaction);
-			});
-			FRequestManager::SendRequest(blockhashRequest);
+				GetOwningWallet()->GetRpcClient()->SendRequest(sendTransaction);
+			}, GetOwningWallet()->GetRpcClient());
 		}
 	});
-	FRequestManager::SendRequest(accountRequest);
+	GetOwningWallet()->GetRpcClient()->SendRequest(accountRequest);
 }
 
 double UWalletAccount::GetSolBalance() const
 {
 	return Lamports.Get(0.f) / 1e9;
 }
+
+void UWalletAccount::SendTransaction(const TArray<uint8>& Transaction, const FBlockhashInfo& Blockhash) const
+{
+	if( Transaction.IsEmpty() )
+	{
+		FRequestUtils::DisplayError(TEXT("Could not build the transaction"));
+		return;
+	}
+
+	// Resent until confirmed. Progress is reported from the signed bytes, without waiting for the first send to be answered.
+	const TWeakObjectPtr<const UWalletAccount> WeakThis(this);
+	FTransactionSender::Send(Transaction, Blockhash, TransactionStatusCallback::CreateLambda([WeakThis](const FString& Signature, ETransactionStatus Status)
+	{
+		if( const UWalletAccount* Account = WeakThis.Get() )
+		{
+			Account->OnTransactionStatus.Broadcast(Signature, Status);
+		}
+
+		if( Status == ETransactionStatus::Confirmed )
+		{
+			FRequestUtils::DisplayInfo(FString::Printf(TEXT("Transaction Id: %s"), *Signature));
+		}
+		else if( Status == ETransactionStatus::Expired )
+		{
+			FRequestUtils::DisplayError(FString::Printf(TEXT("Transaction expired before landing: %s"), *Signature));
+		}
+	}), GetOwningWallet()->GetRpcClient());
+}
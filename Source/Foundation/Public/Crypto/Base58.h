@@ -1,28 +0,0 @@
-﻿/*
-Copyright 2022 ATMTA, Inc.
-
-Licensed under the Apache License, Version 2.0 (the "License");
-you may not use this file except in compliance with the License.
-You may obtain a copy of the License at
-
-	http://www.apache.org/licenses/LICENSE-2.0
-
-Unless required by applicable law or agreed to in writing, software
-distributed under the License is distributed on an "AS IS" BASIS,
-WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
-See the License for the specific language governing permissions and
-limitations under the License.
-
-Author: Jon Sawler
-*/
-#pragma once
-
-#include "CoreMinimal.h"
-
-class FOUNDATION_API FBase58
-{
-public:
-	
-	static FString EncodeBase58( const uint8* data, int len);
-	static TArray<uint8> DecodeBase58( const FString& encoded);
-};
@@ -29,6 +29,15 @@ enum class ESolanaNetwork : uint8
 	Count UMETA(Hidden)
 };
 
+USTRUCT(BlueprintType)
+struct FSolanaEndpointList
+{
+	GENERATED_BODY()
+
+	UPROPERTY(BlueprintReadOnly, EditDefaultsOnly, Config)
+	TArray<FString> URLs;
+};
+
 UCLASS(Config = Foundation, DefaultConfig, BlueprintType, meta = (DisplayName = "Foundation Settings"))
 class FOUNDATION_API UFoundationSettings : public UDeveloperSettings
 {
@@ -49,11 +58,103 @@ public:
 	UFUNCTION(BlueprintPure)
 	FString GetNetworkURL() const;
 
+	// Every RPC endpoint configured for the current network, falling back to the public cluster URL.
+	UFUNCTION(BlueprintPure)
+	TArray<FString> GetNetworkURLs() const;
+
+	UFUNCTION(BlueprintPure)
+	FString GetNetworkWebSocketURL() const;
+
+	UFUNCTION(BlueprintPure)
+	int32 GetMaxBatchSize() const { return FMath::Max(MaxBatchSize, 1); }
+
+	UFUNCTION(BlueprintPure)
+	float GetBatchFlushLatency() const { return FMath::Max(BatchFlushLatency, 0.f); }
+
+	UFUNCTION(BlueprintPure)
+	float GetRequestTimeout() const { return RequestTimeout; }
+
+	UFUNCTION(BlueprintPure)
+	float GetRequestsPerSecond() const { return RequestsPerSecond; }
+
+	UFUNCTION(BlueprintPure)
+	int32 GetMaxInFlightRequests() const { return FMath::Max(MaxInFlightRequests, 1); }
+
+	UFUNCTION(BlueprintPure)
+	int32 GetMaxRequestRetries() const { return MaxRequestRetries; }
+
+	UFUNCTION(BlueprintPure)
+	bool GetCompressResponses() const { return bCompressResponses; }
+
+	UFUNCTION(BlueprintPure)
+	float GetBlockhashRefreshInterval() const { return BlockhashRefreshInterval; }
+
+	UFUNCTION(BlueprintPure)
+	float GetReadCacheTTL() const { return ReadCacheTTL; }
+
+	UFUNCTION(BlueprintPure)
+	float GetConfirmationPollInterval() const { return ConfirmationPollInterval; }
+
+	UFUNCTION(BlueprintPure)
+	float GetRebroadcastInterval() const { return RebroadcastInterval; }
+
 protected:
 
 	UPROPERTY(BlueprintReadOnly, EditDefaultsOnly, Config)
 	TMap<ESolanaNetwork, FString> NetworkURLs;
 
+	/** Additional RPC endpoints per network. Requests are routed to the fastest healthy one. */
+	UPROPERTY(BlueprintReadOnly, EditDefaultsOnly, Config)
+	TMap<ESolanaNetwork, FSolanaEndpointList> NetworkEndpoints;
+
+	/** Pubsub endpoint per network. When missing it is derived from the network URL. */
+	UPROPERTY(BlueprintReadOnly, EditDefaultsOnly, Config)
+	TMap<ESolanaNetwork, FString> NetworkWebSocketURLs;
+
 	UPROPERTY(BlueprintReadOnly, EditDefaultsOnly, Config)
 	ESolanaNetwork Network = ESolanaNetwork::DevNet;
+
+	/** Maximum number of JSON-RPC calls sent together in one batch. 1 disables batching. */
+	UPROPERTY(BlueprintReadOnly, EditDefaultsOnly, Config, meta = (ClampMin = 1))
+	int32 MaxBatchSize = 20;
+
+	/** Seconds a request waits for others to join its batch. 0 sends everything queued on the next tick. */
+	UPROPERTY(BlueprintReadOnly, EditDefaultsOnly, Config, meta = (ClampMin = 0, Units = "s"))
+	float BatchFlushLatency = 0.f;
+
+	/** Seconds before a request without a response is failed and released. */
+	UPROPERTY(BlueprintReadOnly, EditDefaultsOnly, Config, meta = (ClampMin = 1, Units = "s"))
+	float RequestTimeout = 30.f;
+
+	/** HTTP posts per second sent to each endpoint, a batch counting as one. Lowered automatically while an endpoint throttles. 0 removes the limit. */
+	UPROPERTY(BlueprintReadOnly, EditDefaultsOnly, Config, meta = (ClampMin = 0))
+	float RequestsPerSecond = 10.f;
+
+	/** HTTP posts awaiting a response at any time. Further batches wait their turn. */
+	UPROPERTY(BlueprintReadOnly, EditDefaultsOnly, Config, meta = (ClampMin = 1))
+	int32 MaxInFlightRequests = 8;
+
+	/** Times a read is sent again after a throttled or failed HTTP request. Transactions are never resent. */
+	UPROPERTY(BlueprintReadOnly, EditDefaultsOnly, Config, meta = (ClampMin = 0))
+	int32 MaxRequestRetries = 3;
+
+	/** Ask endpoints to gzip the responses of large account reads. */
+	UPROPERTY(BlueprintReadOnly, EditDefaultsOnly, Config)
+	bool bCompressResponses = true;
+
+	/** Seconds between background refreshes of the cached blockhash used to build transactions. */
+	UPROPERTY(BlueprintReadOnly, EditDefaultsOnly, Config, meta = (ClampMin = 1, Units = "s"))
+	float BlockhashRefreshInterval = 10.f;
+
+	/** Seconds an account read is answered from the cache. 0 disables the cache. */
+	UPROPERTY(BlueprintReadOnly, EditDefaultsOnly, Config, meta = (ClampMin = 0, Units = "s"))
+	float ReadCacheTTL = 5.f;
+
+	/** Seconds between status polls of sent transactions awaiting confirmation. All of them share one call per poll. */
+	UPROPERTY(BlueprintReadOnly, EditDefaultsOnly, Config, meta = (ClampMin = 0.1, Units = "s"))
+	float ConfirmationPollInterval = 0.5f;
+
+	/** Seconds between resends of a transaction that is not confirmed yet. Resending stops once its blockhash expires. */
+	UPROPERTY(BlueprintReadOnly, EditDefaultsOnly, Config, meta = (ClampMin = 0.5, Units = "s"))
+	float RebroadcastInterval = 2.f;
 };
\ No newline at end of file
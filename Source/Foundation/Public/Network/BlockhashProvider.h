@@ -0,0 +1,64 @@
+/*
+Copyright 2022 ATMTA, Inc.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+	http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+*/
+#pragma once
+
+#include "CoreMinimal.h"
+
+struct FBlockhashInfo
+{
+	FString Blockhash;
+	uint64 LastValidBlockHeight = 0;
+	uint64 Slot = 0;
+	double FetchTime = 0.0;
+
+	bool IsValid() const { return !Blockhash.IsEmpty(); }
+};
+
+typedef TFunction<void(const FBlockhashInfo&)> BlockhashCallback;
+
+class FSolanaRpcClient;
+struct FClientBlockhash;
+
+/**
+ * FBlockhashProvider
+ *
+ * Keeps a recent blockhash warm so transactions can be built without waiting for a round trip.
+ * The blockhash is refreshed in the background for as long as transactions are being built.
+ * Each client has its own, since it may talk to another network; a null client stands for the default one.
+ */
+class FOUNDATION_API FBlockhashProvider
+{
+public:
+
+	// Get the cached blockhash if enough blocks are left before its last valid block height to land a transaction.
+	static bool TryGetBlockhash(FBlockhashInfo& OutBlockhash, const TSharedPtr<FSolanaRpcClient>& Client = nullptr);
+
+	// Call back right away with the cached blockhash, or as soon as a fresh one arrives.
+	static void GetBlockhash(BlockhashCallback Callback, const TSharedPtr<FSolanaRpcClient>& Client = nullptr);
+
+	static void Refresh(const TSharedPtr<FSolanaRpcClient>& Client = nullptr);
+
+	// Current block height of the client's network, as polled by whoever is watching it.
+	static void ReportBlockHeight(const FSolanaRpcClient* Client, uint64 BlockHeight);
+
+	static void Shutdown();
+
+private:
+
+	static bool OnRefreshTimer(float DeltaTime);
+	static void OnBlockhashReceived(FClientBlockhash& State, const FBlockhashInfo& Blockhash);
+};
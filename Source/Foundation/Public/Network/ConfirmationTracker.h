@@ -0,0 +1,66 @@
+/*
+Copyright 2022 ATMTA, Inc.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+	http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+*/
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Network/RequestUtils.h"
+
+DECLARE_DELEGATE_TwoParams( TransactionStatusCallback, const FString& Signature, ETransactionStatus Status);
+
+class FSolanaRpcClient;
+
+/**
+ * FConfirmationTracker
+ *
+ * Follows sent transactions until they are finalized, fail or expire. Outstanding signatures are polled together,
+ * one getSignatureStatuses per client and poll, and those on the default network are also pushed over
+ * signatureSubscribe while the websocket is connected.
+ * Callbacks fire once for each of processed, confirmed and finalized, in that order, even when a poll skips a level.
+ */
+class FOUNDATION_API FConfirmationTracker
+{
+public:
+
+	// Track a signed transaction, ideally before it is sent. Returns its signature, computed from the signed bytes.
+	// Unseen transactions are reported Expired after a while, unless bTimeout is false because the caller watches the blockhash.
+	// Landed ones that never finalize are dropped later without a callback, their last reported status standing.
+	// Statuses are polled through Client, which must be on the network the transaction was sent to. Null uses the default one.
+	static FString Track(const TArray<uint8>& Transaction, TransactionStatusCallback Callback, bool bTimeout = true, const TSharedPtr<FSolanaRpcClient>& Client = nullptr);
+	static void Track(const FString& Signature, TransactionStatusCallback Callback, bool bTimeout = true, const TSharedPtr<FSolanaRpcClient>& Client = nullptr);
+
+	// Stop tracking without calling back.
+	static void Untrack(const FString& Signature);
+
+	// Report a transaction the node refused to accept, e.g. when sendTransaction fails its preflight.
+	static void Fail(const FString& Signature);
+
+	// Report a transaction whose blockhash expired before it landed. Ignored once it has been seen processed.
+	static void Expire(const FString& Signature);
+
+	static bool IsTracking(const FString& Signature);
+
+	static void Shutdown();
+
+private:
+
+	static bool OnPollTimer(float DeltaTime);
+	static void Poll();
+	static void Poll(const TSharedRef<FSolanaRpcClient>& Client);
+	static void Subscribe(const FString& Signature);
+	static void OnStatusReceived(const FString& Signature, ETransactionStatus Status);
+	static void Remove(const FString& Signature);
+};
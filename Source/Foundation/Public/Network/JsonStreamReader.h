@@ -0,0 +1,144 @@
+/*
+Copyright 2022 ATMTA, Inc.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+	http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+*/
+#pragma once
+
+#include "CoreMinimal.h"
+
+enum class EJsonStreamToken : uint8
+{
+	None,
+	ObjectStart,
+	ObjectEnd,
+	ArrayStart,
+	ArrayEnd,
+	String,
+	Number,
+	True,
+	False,
+	Null,
+	Error
+};
+
+/**
+ * FJsonStreamReader
+ *
+ * Pull tokenizer over UTF-8 JSON bytes. Values are decoded on demand straight into the caller's
+ * structs, so no FJsonValue tree is built. Unescaping goes through one scratch buffer owned by the
+ * reader. Separators are skipped rather than validated; the input is trusted RPC output.
+ */
+class FOUNDATION_API FJsonStreamReader
+{
+public:
+
+	FJsonStreamReader(const uint8* InData, int32 InSize);
+
+	// Advance to the next token.
+	EJsonStreamToken Next();
+	EJsonStreamToken GetToken() const { return Token; }
+
+	// On an object start or a previous member value: move to the next key. False at the end of the object.
+	bool NextMember();
+
+	// On an array start or a previous element: move to the first token of the next element. False at the end of the array.
+	bool NextElement();
+
+	// Leave the reader on the last token of the value the current token starts.
+	bool SkipValue();
+
+	// Move past the current key's value.
+	bool SkipMemberValue() { Next(); return SkipValue(); }
+
+	bool IsKey() const { return Token == EJsonStreamToken::String && bIsKey; }
+	bool KeyEquals(const ANSICHAR* Key) const;
+
+	FString GetString();
+	double GetNumber() const;
+	uint64 GetUInt64() const;
+	bool GetBool() const { return Token == EJsonStreamToken::True; }
+
+	// Byte offset where the current token starts, and the offset just past it.
+	int32 GetTokenStart() const { return TokenStart; }
+	int32 GetOffset() const { return Offset; }
+
+	bool HasError() const { return Token == EJsonStreamToken::Error; }
+
+	// On an object start: call OnMember on each key. OnMember reads or skips the value and returns false to stop. Null reads as an empty object.
+	template<typename FunctorType>
+	bool ReadObject(FunctorType&& OnMember)
+	{
+		if( Token == EJsonStreamToken::Null )
+		{
+			return true;
+		}
+		if( Token != EJsonStreamToken::ObjectStart )
+		{
+			return false;
+		}
+		while( NextMember() )
+		{
+			if( !OnMember() )
+			{
+				return false;
+			}
+		}
+		return Token == EJsonStreamToken::ObjectEnd;
+	}
+
+	// On an array start: call OnElement on the first token of each element. Null reads as an empty array.
+	template<typename FunctorType>
+	bool ReadArray(FunctorType&& OnElement)
+	{
+		if( Token == EJsonStreamToken::Null )
+		{
+			return true;
+		}
+		if( Token != EJsonStreamToken::ArrayStart )
+		{
+			return false;
+		}
+		while( NextElement() )
+		{
+			if( !OnElement() )
+			{
+				return false;
+			}
+		}
+		return Token == EJsonStreamToken::ArrayEnd;
+	}
+
+	// Read the value of the current key.
+	bool ReadString(FString& Out) { Next(); Out = GetString(); return Token == EJsonStreamToken::String || Token == EJsonStreamToken::Null; }
+	bool ReadNumber(double& Out) { Next(); Out = GetNumber(); return Token == EJsonStreamToken::Number || Token == EJsonStreamToken::Null; }
+	bool ReadBool(bool& Out) { Next(); Out = GetBool(); return Token == EJsonStreamToken::True || Token == EJsonStreamToken::False || Token == EJsonStreamToken::Null; }
+
+private:
+
+	bool MatchLiteral(const ANSICHAR* Literal, int32 Length);
+	bool Unescape();
+
+	const uint8* Data;
+	int32 Size;
+	int32 Offset = 0;
+
+	EJsonStreamToken Token = EJsonStreamToken::None;
+	int32 TokenStart = 0;
+	int32 TokenEnd = 0;
+	bool bIsKey = false;
+	bool bHasEscapes = false;
+
+	TArray<ANSICHAR> Scratch;
+};
@@ -0,0 +1,43 @@
+/*
+Copyright 2022 ATMTA, Inc.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+	http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+*/
+#pragma once
+
+#include "CoreMinimal.h"
+
+/**
+ * FRateLimiter
+ *
+ * Token bucket per RPC endpoint. The rate starts at the configured requests per second,
+ * is halved whenever the endpoint throttles us and creeps back up as requests succeed.
+ */
+class FOUNDATION_API FRateLimiter
+{
+public:
+
+	// Take a token for URL if one is available.
+	static bool TryAcquire(const FString& URL);
+
+	// Seconds until TryAcquire can succeed for URL.
+	static double GetWaitTime(const FString& URL);
+
+	static void OnSuccess(const FString& URL);
+
+	// The endpoint answered 429. Nothing is sent to it for RetryAfter seconds when that is known.
+	static void OnThrottled(const FString& URL, double RetryAfter);
+
+	static void Reset();
+};
@@ -0,0 +1,62 @@
+/*
+Copyright 2022 ATMTA, Inc.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+	http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+*/
+#pragma once
+
+#include "CoreMinimal.h"
+
+struct FRequestData;
+struct FRequestResult;
+
+struct FRequestCacheStats
+{
+	int64 Hits = 0;
+	int64 Misses = 0;
+	int64 Invalidations = 0;
+};
+
+/**
+ * FRequestCache
+ *
+ * Keeps the responses of account reads keyed by method and params, which include the pubkey and commitment.
+ * Reads with a bound result keep the decoded result instead of the FJsonObject, keyed by its type as well.
+ * Entries expire after the configured TTL, when a newer slot is known for one of their accounts,
+ * or when a transaction touching one of their accounts is sent.
+ */
+class FOUNDATION_API FRequestCache
+{
+public:
+
+	static bool IsCacheable(const FRequestData& Request);
+
+	// Scope keeps apart the entries of clients talking to different networks.
+	// Both copy the response, so callbacks can modify what they are given without touching the cached one.
+	static TSharedPtr<FJsonObject> Find(const FRequestData& Request, const FString& Scope = FString());
+	static void Store(const FRequestData& Request, const TSharedPtr<FJsonObject>& Response, const FString& Scope = FString());
+
+	// Decoded results are immutable, so they are shared rather than copied. Slot is the one the result was read at.
+	static TSharedPtr<const FRequestResult> FindResult(const FRequestData& Request, const FString& Scope = FString());
+	static void StoreResult(const FRequestData& Request, const TSharedPtr<const FRequestResult>& Result, uint64 Slot, const FString& Scope = FString());
+
+	// Drop every entry that read this account.
+	static void Invalidate(const FString& PubKey);
+	// Treat every entry for this account read before Slot as stale.
+	static void Invalidate(const FString& PubKey, uint64 Slot);
+
+	static void Empty();
+
+	static const FRequestCacheStats& GetStats();
+};
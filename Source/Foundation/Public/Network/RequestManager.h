@@ -28,29 +28,188 @@ DECLARE_DELEGATE_OneParam( RequestErrorCallback, const FText& FailureReason);
 
 typedef TFunctionRef<void(FJsonObject&)> RequestCB;
 
+class FJsonStreamReader;
+class FSolanaRpcClient;
+
+// Order in which queued requests are posted. Background requests also leave one in-flight slot free for the others.
+enum class ERequestPriority : uint8
+{
+	// Sending and confirming transactions.
+	Transaction,
+	// Reads someone is waiting on.
+	Interactive,
+	// Balance polling and other refreshes nobody is waiting on.
+	Background
+};
+
+// A decoded "result", shared read-only between the requests it answers and FRequestCache. See FRequestData::BindResult.
+struct FRequestResult
+{
+	virtual ~FRequestResult() {}
+};
+
+template<typename ValueType>
+struct TRequestResult : FRequestResult
+{
+	ValueType Value;
+
+	// Unique per value type, which is all that is needed to tell results apart without RTTI.
+	static const void* GetTypeId()
+	{
+		static const uint8 TypeId = 0;
+		return &TypeId;
+	}
+};
+
 struct FOUNDATION_API FRequestData
 {
 	FRequestData() {}
-	FRequestData( UINT id ) { Id = id; }
+	FRequestData( const FString& InMethod, const FString& InParams );
+
+	FRequestData( const FRequestData& ) = delete;
+	FRequestData& operator=( const FRequestData& ) = delete;
 
-	UINT Id;
-	FString Body;
+	// Given by the client the request is sent through. Every client has its own id space.
+	uint32 Id = 0;
+	FString Method;
+	FString Params;
+
+	// The JSON-RPC call, encoded to UTF-8 once its id is known so it can be posted as is.
+	TArray<uint8> Body;
+	void EncodeBody();
 	RequestCallback Callback;
 	RequestErrorCallback ErrorCallback;
+
+	// Optional, set by BindResult. Decodes "result" straight from the response bytes on a worker thread, so it must not
+	// touch game state; null on failure. ResultCallback then runs on the game thread instead of Callback.
+	TFunction<TSharedPtr<const FRequestResult>(FJsonStreamReader&)> ResultDecoder;
+	TFunction<void(const FRequestResult&)> ResultCallback;
+	const void* ResultTypeId = nullptr;
+
+	// Method and params, plus the bound result type. Requests with the same key can be answered by the same response.
+	FString GetReadKey() const;
+
+	// Accounts read by this request, or touched by it for a transaction. Reads with accounts are served from FRequestCache.
+	TArray<FString> AccountKeys;
+
+	ERequestPriority Priority = ERequestPriority::Interactive;
+
+	// Set on a cancelled request kept alive only for the identical reads riding on it.
+	bool bCancelled = false;
+
+	// Ask for a gzipped response. Set by the request builders whose responses are large enough to be worth it.
+	bool bCompressResponse = false;
+
+	// RPC endpoint the request was last posted to.
+	FString Endpoint;
+	int32 Retries = 0;
+
+	// Seconds to wait for a response before ErrorCallback fires. 0 uses the project setting.
+	float Timeout = 0.f;
+	double ExpireTime = 0.0;
+
+	// Identical reads sent while this one was in flight. They complete with this request's response.
+	TArray<TUniquePtr<FRequestData>> Duplicates;
+
+	// Decode the result into a ResultType with Decoder and hand it to OnResult, without building a FJsonObject.
+	template<typename ResultType>
+	void BindResult(TFunction<bool(FJsonStreamReader&, ResultType&)> Decoder, TFunction<void(const ResultType&)> OnResult)
+	{
+		ResultDecoder = [Decoder](FJsonStreamReader& Reader) -> TSharedPtr<const FRequestResult>
+		{
+			const TSharedRef<TRequestResult<ResultType>> Result = MakeShared<TRequestResult<ResultType>>();
+			if( !Decoder(Reader, Result->Value) )
+			{
+				return nullptr;
+			}
+			return Result;
+		};
+		ResultCallback = [OnResult](const FRequestResult& Result)
+		{
+			OnResult(static_cast<const TRequestResult<ResultType>&>(Result).Value);
+		};
+		ResultTypeId = TRequestResult<ResultType>::GetTypeId();
+	}
+};
+
+struct FRequestStats
+{
+	// Calls handed to SendRequest.
+	int64 Requests = 0;
+	// HTTP posts made, a batch counting as one.
+	int64 HttpRequests = 0;
+	// Calls answered by an identical call already in flight.
+	int64 Collapsed = 0;
+	int64 TimedOut = 0;
+	int64 Failed = 0;
+	// Calls sent again after a failed or throttled HTTP request.
+	int64 Retried = 0;
+	// HTTP requests answered with 429.
+	int64 Throttled = 0;
+	// Calls cancelled before they completed.
+	int64 Cancelled = 0;
+	// HTTP responses that arrived gzipped.
+	int64 CompressedResponses = 0;
+	// Response bytes as received, and once inflated.
+	int64 BytesReceived = 0;
+	int64 BytesDecoded = 0;
 };
 
+/**
+ * FRequestManager
+ *
+ * Sends requests through the default FSolanaRpcClient, which talks to the network picked in the project settings.
+ * Anything that needs another network or its own queue holds a client of its own instead.
+ */
 class FOUNDATION_API FRequestManager
 {
 public:
 
-	static int64 GetNextMessageID();
-	static int64 GetLastMessageID();
+	static void Startup();
+	static void Shutdown();
 
+	static TSharedRef<FSolanaRpcClient> GetDefaultClient();
+
+	// Takes ownership of RequestData. It is deleted once its callback or error callback has run.
 	static void SendRequest(FRequestData* RequestData);
 
 	static void CancelRequest(FRequestData* RequestData);
+	static void CancelRequest(uint32 Id);
+
+	static const FRequestStats& GetStats();
+
+	// Hold every request sent until the matching FlushBatch and send them as one JSON-RPC batch.
+	static void BeginBatch();
+	static void FlushBatch();
+};
+
+/**
+ * FRequestBatchScope
+ *
+ * Every request sent through the client while this object is alive goes out in the same JSON-RPC batch.
+ */
+struct FOUNDATION_API FRequestBatchScope
+{
+	FRequestBatchScope();
+	explicit FRequestBatchScope(const TSharedRef<FSolanaRpcClient>& InClient);
+	~FRequestBatchScope();
+
+private:
+
+	TSharedRef<FSolanaRpcClient> Client;
+};
+
+/**
+ * FRequestPriorityScope
+ *
+ * Requests sent through the client while this object is alive, and left at the default priority, get Priority instead.
+ */
+struct FOUNDATION_API FRequestPriorityScope
+{
+	FRequestPriorityScope(const TSharedRef<FSolanaRpcClient>& InClient, ERequestPriority Priority);
+	~FRequestPriorityScope();
 
 private:
 
-	static void OnResponse(FHttpRequestPtr Request, FHttpResponsePtr Response, bool bSuccess);
+	TSharedRef<FSolanaRpcClient> Client;
 };
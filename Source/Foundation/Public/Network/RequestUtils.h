@@ -20,17 +20,92 @@ Author: Jon Sawler
 #include "CoreMinimal.h"
 
 struct FRequestData;
+class FJsonStreamReader;
 struct FAccountInfoJson;
 struct FBalanceResultJson;
 struct FTokenAccountArrayJson;
 struct FProgramAccountJson;
+struct FLatestBlockhashJson;
+struct FTokenAccountEntry;
+struct FTokenAccountLayout;
+class FSolanaRpcClient;
+
+constexpr int32 MaxMultipleAccountsKeys = 100;
+constexpr int32 MaxSignatureStatuses = 256;
+
+// How account data is sent back. Binary encodings are decoded natively and are far smaller than jsonParsed.
+// Base64Zstd needs zstd in Source/Foundation/ThirdParty/zstd, which is not shipped with the plugin. Builds without it
+// (FOUNDATION_WITH_ZSTD 0) request Base64 instead, and say so in the log at startup.
+enum class EAccountEncoding : uint8
+{
+	Base58,
+	Base64,
+	Base64Zstd,
+	JsonParsed
+};
+
+// Bytes of account data to download. A zero length reads none, leaving only lamports, owner and the like.
+struct FDataSlice
+{
+	uint64 Offset = 0;
+	uint64 Length = 0;
+};
+
+// How far a sent transaction has come. Failed transactions landed with an error, expired ones never landed.
+enum class ETransactionStatus : uint8
+{
+	Pending,
+	Processed,
+	Confirmed,
+	Finalized,
+	Failed,
+	Expired
+};
+
+enum class EMemcmpEncoding : uint8
+{
+	Base58,
+	Base64
+};
+
+/**
+ * FProgramAccountsQuery
+ *
+ * Filters and projection for a getProgramAccounts call. Every filter must match for an account to be returned,
+ * and DataSlice limits the bytes downloaded for each account.
+ */
+struct FOUNDATION_API FProgramAccountsQuery
+{
+	explicit FProgramAccountsQuery(const FString& InProgramId) : ProgramId(InProgramId) {}
+
+	FProgramAccountsQuery& DataSize(uint64 Size);
+	FProgramAccountsQuery& Memcmp(uint64 Offset, const FString& Bytes, EMemcmpEncoding Encoding = EMemcmpEncoding::Base58);
+	FProgramAccountsQuery& Memcmp(uint64 Offset, const TArray<uint8>& Bytes);
+	FProgramAccountsQuery& DataSlice(uint64 Offset, uint64 Length);
+	FProgramAccountsQuery& Commitment(const FString& InCommitment);
+	FProgramAccountsQuery& Encoding(EAccountEncoding InEncoding);
+
+	FString ToParams() const;
+
+	FString ProgramId;
+
+private:
+
+	TArray<FString> Filters;
+	FString Slice;
+	FString CommitmentLevel;
+	EAccountEncoding AccountEncoding = EAccountEncoding::Base64;
+};
 
 class FOUNDATION_API FRequestUtils
 {
 public:
 	
-	static FRequestData* RequestAccountInfo(const FString& pubKey);
+	// Without a slice the whole account data is downloaded.
+	static FRequestData* RequestAccountInfo(const FString& pubKey, const TOptional<FDataSlice>& slice = NullOpt, EAccountEncoding encoding = EAccountEncoding::Base64);
 	static FAccountInfoJson ParseAccountInfoResponse(const FJsonObject& data);
+	// Unset when the account does not exist.
+	static bool DecodeAccountInfoResult(FJsonStreamReader& reader, TOptional<FAccountInfoJson>& outData);
 
 	static FRequestData* RequestAccountBalance(const FString& pubKey);
 	static double ParseAccountBalanceResponse(const FJsonObject& data);
@@ -38,26 +113,62 @@ public:
 	static FRequestData* RequestTokenAccount(const FString& pubKey, const FString& mint);
 	static FString ParseTokenAccountResponse(const FJsonObject& data);
 
-	static FRequestData* RequestAllTokenAccounts(const FString& pubKey, const FString& programID);
+	static FRequestData* RequestAllTokenAccounts(const FString& pubKey, const FString& programID, EAccountEncoding encoding = EAccountEncoding::JsonParsed);
 	static FTokenAccountArrayJson ParseAllTokenAccountsResponse(const FJsonObject& data);
+	static bool DecodeAllTokenAccountsResult(FJsonStreamReader& reader, FTokenAccountArrayJson& outData);
+
+	// Decode token accounts requested with a binary encoding.
+	static bool DecodeTokenAccountsResult(FJsonStreamReader& reader, TArray<FTokenAccountEntry>& outData);
+	// Decode account data sent as [data, encoding] into raw bytes. Safe to call from decoders on worker threads.
+	// outBytes points into a per thread buffer, valid until the next call on the same thread.
+	static bool DecodeAccountData(const FString& data, const FString& encoding, TConstArrayView<uint8>& outBytes);
+	// Decode the binary "data" of an account object, as pushed by account and program notifications.
+	static bool ParseTokenAccountData(const FJsonObject& account, FTokenAccountLayout& outAccount);
+
+	// Decimals of each mint, fetched once per session. Mints that could not be read are left out.
+	static void FetchMintDecimals(const TArray<FString>& mints, TFunction<void(const TMap<FString, uint8>&)> callback, const TSharedPtr<FSolanaRpcClient>& client = nullptr);
 
 	static FRequestData* RequestProgramAccounts(const FString& programID, const UINT& size, const FString& pubKey);
+	static FRequestData* RequestProgramAccounts(const FProgramAccountsQuery& query);
 	static TArray<FProgramAccountJson> ParseProgramAccountsResponse(const FJsonObject& data);
+	static bool DecodeProgramAccountsResult(FJsonStreamReader& reader, TArray<FProgramAccountJson>& outData);
+	// Send the query and decode the accounts straight from the response, without building a FJsonObject for each one.
+	static void FetchProgramAccounts(const FProgramAccountsQuery& query, TFunction<void(const TArray<FProgramAccountJson>&)> callback, TFunction<void(const FText&)> errorCallback = nullptr, const TSharedPtr<FSolanaRpcClient>& client = nullptr);
 
-	static FRequestData* RequestMultipleAccounts(const TArray<FString>& pubKey);
+	// One getMultipleAccounts call. The node rejects more than MaxMultipleAccountsKeys keys; FetchMultipleAccounts splits larger sets.
+	// Reads no account data by default. Pass NullOpt as the slice to download all of it.
+	static FRequestData* RequestMultipleAccounts(const TArray<FString>& pubKey, const TOptional<FDataSlice>& slice = FDataSlice(), EAccountEncoding encoding = EAccountEncoding::Base64);
 	static TArray<FAccountInfoJson> ParseMultipleAccountsResponse(const FJsonObject& data);
+	static bool DecodeMultipleAccountsResult(FJsonStreamReader& reader, TArray<TOptional<FAccountInfoJson>>& outData);
+
+	// Fetch any number of accounts in concurrent chunks. Accounts are keyed by pubkey in input order; missing ones are left out.
+	// A null client sends through the default one.
+	static void FetchMultipleAccounts(const TArray<FString>& pubKeys, TFunction<void(const TMap<FString, FAccountInfoJson>&)> callback, TFunction<void(const FText&)> errorCallback = nullptr, const TSharedPtr<FSolanaRpcClient>& client = nullptr);
+	static void FetchMultipleAccounts(const TArray<FString>& pubKeys, const TOptional<FDataSlice>& slice, EAccountEncoding encoding, TFunction<void(const TMap<FString, FAccountInfoJson>&)> callback, TFunction<void(const FText&)> errorCallback = nullptr, const TSharedPtr<FSolanaRpcClient>& client = nullptr);
 	
 	static FRequestData* RequestBlockHash();
 	static FString ParseBlockHashResponse(const FJsonObject& data);
+	static FLatestBlockhashJson ParseLatestBlockHashResponse(const FJsonObject& data);
+
+	static FRequestData* RequestBlockHeight();
+	static uint64 ParseBlockHeightResponse(const FJsonObject& data);
 
 	static FRequestData* GetTransactionFeeAmount(const FString& transaction);
 	static int ParseTransactionFeeAmountResponse(const FJsonObject& data);
 	
-	static FRequestData* SendTransaction(const FString& transaction);
+	// A negative maxRetries leaves rebroadcasting to the node. FTransactionSender passes 0 and resends itself.
+	static FRequestData* SendTransaction(const FString& transaction, bool skipPreflight = false, int32 maxRetries = -1);
 	static FString ParseTransactionResponse(const FJsonObject& data);
+
+	// One getSignatureStatuses call for at most MaxSignatureStatuses signatures. Only the recent status cache is searched.
+	static FRequestData* RequestSignatureStatuses(const TArray<FString>& signatures);
+	// Status of each signature in request order, Pending for those the node has not seen yet.
+	static TArray<ETransactionStatus> ParseSignatureStatusesResponse(const FJsonObject& data);
 	
 	static FRequestData* RequestAirDrop(const FString& pubKey);
 
+	static const TCHAR* GetEncodingName(EAccountEncoding encoding);
+
 	static void DisplayError(const FString& error);
 	static void DisplayInfo(const FString& info);
 };
@@ -0,0 +1,72 @@
+/*
+Copyright 2022 ATMTA, Inc.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+	http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+*/
+#pragma once
+
+#include "CoreMinimal.h"
+
+struct FRpcEndpointStats
+{
+	FString URL;
+
+	// Smoothed round trip in seconds. 0 until the first response.
+	double Latency = 0.0;
+
+	// Smoothed share of failed requests, 0 to 1.
+	double ErrorRate = 0.0;
+
+	int32 ConsecutiveFailures = 0;
+	int32 Requests = 0;
+	int32 Failures = 0;
+
+	// The circuit is open while this lies in the future. Once it passes a single probe is let through.
+	double OpenUntil = 0.0;
+	int32 Trips = 0;
+	bool bProbing = false;
+	// When the probe was let through. A probe that never reports back, cancelled or aborted, is given up on after a timeout.
+	double ProbeStartTime = 0.0;
+
+	bool IsOpen(double Now) const { return OpenUntil > Now; }
+};
+
+/**
+ * FRpcRouter
+ *
+ * Picks the RPC endpoint each request goes to among the ones configured for the current network, or given by a client.
+ * Endpoints are ranked by smoothed latency and error rate, and an endpoint that keeps failing
+ * is ejected for a growing cooldown before a single probe request is allowed to bring it back.
+ */
+class FOUNDATION_API FRpcRouter
+{
+public:
+
+	static FString SelectEndpoint();
+	// Pick among the given URLs, for clients that do not follow the project network.
+	static FString SelectEndpoint(const TArray<FString>& URLs);
+
+	static void ReportSuccess(const FString& URL, double Latency);
+	static void ReportFailure(const FString& URL, double Latency);
+
+	static TArray<FRpcEndpointStats> GetEndpoints();
+
+	static void Reset();
+
+private:
+
+	static FRpcEndpointStats* FindEndpoint(const FString& URL);
+	static FRpcEndpointStats& FindOrAddEndpoint(const FString& URL);
+	static double GetScore(const FRpcEndpointStats& Endpoint);
+};
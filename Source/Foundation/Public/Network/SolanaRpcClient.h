@@ -0,0 +1,145 @@
+/*
+Copyright 2022 ATMTA, Inc.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+	http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+*/
+#pragma once
+
+#include "CoreMinimal.h"
+
+#include <atomic>
+
+#include "Containers/Queue.h"
+#include "Containers/Ticker.h"
+#include "Interfaces/IHttpRequest.h"
+#include "Network/RequestManager.h"
+
+struct FDecodedResponse;
+struct FDecodedEntry;
+
+/**
+ * FSolanaRpcClient
+ *
+ * Sends JSON-RPC requests to one network. Every client has its own endpoints, id space, batching, send queue and stats,
+ * so several networks can be used at once. Requests can be sent from any thread; they are picked up on the game thread,
+ * where every callback runs as well.
+ */
+class FOUNDATION_API FSolanaRpcClient : public TSharedFromThis<FSolanaRpcClient>
+{
+public:
+
+	// With no endpoints the client follows the network picked in the project settings.
+	explicit FSolanaRpcClient(const TArray<FString>& InEndpoints = TArray<FString>());
+	~FSolanaRpcClient();
+
+	FSolanaRpcClient(const FSolanaRpcClient&) = delete;
+	FSolanaRpcClient& operator=(const FSolanaRpcClient&) = delete;
+
+	// Takes ownership of RequestData. It is deleted once its callback or error callback has run.
+	void SendRequest(FRequestData* RequestData);
+
+	// Drop the request without running any of its callbacks. Once nothing else in its HTTP request is left,
+	// that HTTP request is aborted and its in-flight slot freed. Game thread only.
+	void CancelRequest(FRequestData* RequestData);
+	void CancelRequest(uint32 Id);
+
+	const FRequestStats& GetStats() const { return Stats; }
+
+	TArray<FString> GetEndpoints() const;
+
+	// Hold every request sent until the matching FlushBatch and send them as one JSON-RPC batch. Game thread only.
+	void BeginBatch();
+	void FlushBatch();
+
+	// See FRequestPriorityScope. Game thread only.
+	void PushPriority(ERequestPriority Priority);
+	void PopPriority();
+
+private:
+
+	// Batches ready to post, waiting for a free in-flight slot, a rate limiter token or their retry time.
+	struct FOutboundBatch
+	{
+		TArray<uint32> Ids;
+		double NotBefore = 0.0;
+		ERequestPriority Priority = ERequestPriority::Interactive;
+	};
+
+	struct FInFlightPost
+	{
+		FHttpRequestPtr Request;
+		TArray<uint32> Ids;
+	};
+
+	void AcceptRequest(FRequestData* RequestData);
+	bool OnSubmissionTick(float DeltaTime);
+
+	void ScheduleFlush();
+	bool OnFlushTimer(float DeltaTime);
+	void FlushQueuedRequests();
+	void EnqueueBatch(FOutboundBatch&& Batch);
+	void AbortOrphanedPosts();
+	void PumpSendQueue();
+	bool OnPumpTimer(float DeltaTime);
+	void PostRequestBody(const FString& Url, const TArray<uint32>& Ids);
+	void RetryRequests(const TArray<uint32>& Ids, double RetryAfter, const FText& FailureReason);
+
+	bool OnTimeoutSweep(float DeltaTime);
+	void FailRequests(const TArray<uint32>& Ids, const FText& FailureReason);
+	void CompleteRequest(FRequestData& Request, const TSharedPtr<FJsonObject>& Response);
+	TUniquePtr<FRequestData> TakePendingRequest(uint32 Id);
+
+	void OnResponse(FHttpRequestPtr Request, FHttpResponsePtr Response, bool bSuccess, TArray<uint32> Ids);
+	void DispatchResponse(const TSharedPtr<FJsonObject>& ParsedJSON);
+	bool OnCompletionTick(float DeltaTime);
+	void CompleteDecodedResponse(FDecodedResponse& Decoded);
+	void CompleteDecodedResult(const FDecodedEntry& Entry);
+
+	// Empty when following the project settings.
+	TArray<FString> Endpoints;
+
+	// Keeps the read cache entries of clients on different networks apart.
+	FString CacheScope;
+
+	std::atomic<uint32> NextId { 0 };
+
+	// Requests sent from other threads, waiting for the game thread.
+	TQueue<FRequestData*, EQueueMode::Mpsc> Submissions;
+	std::atomic<bool> bSubmissionTickPending { false };
+
+	TMap<uint32, TUniquePtr<FRequestData>> PendingRequests;
+
+	// Method and params of every deduplicable read in flight, mapped to the request carrying it.
+	TMap<FString, uint32> InFlightReads;
+
+	FRequestStats Stats;
+
+	TArray<uint32> QueuedRequests;
+	int32 BatchScopeDepth = 0;
+	TArray<ERequestPriority> PriorityScopes;
+
+	// Highest priority first, in the order sent within a priority.
+	TArray<FOutboundBatch> SendQueue;
+	TArray<uint8> BatchBody;
+	TArray<FInFlightPost> InFlightPosts;
+
+	// Filled from the thread pool, drained on the game thread.
+	TQueue<FDecodedResponse*, EQueueMode::Mpsc> DecodedResponses;
+	int32 DecodesInFlight = 0;
+
+	FTSTicker::FDelegateHandle FlushTimerHandle;
+	FTSTicker::FDelegateHandle TimeoutTimerHandle;
+	FTSTicker::FDelegateHandle PumpTimerHandle;
+	FTSTicker::FDelegateHandle CompletionTimerHandle;
+};
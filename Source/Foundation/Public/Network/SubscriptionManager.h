@@ -0,0 +1,74 @@
+/*
+Copyright 2022 ATMTA, Inc.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+	http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+*/
+#pragma once
+
+#include "CoreMinimal.h"
+
+DECLARE_DELEGATE_OneParam( SubscriptionCallback, const FJsonObject& Result);
+
+struct FSubscriptionData
+{
+	FString Method;
+	FString Params;
+	SubscriptionCallback Callback;
+
+	// Signature subscriptions are closed by the node after their first notification.
+	bool bOneShot = false;
+
+	// Id the node assigned to this subscription, reset on reconnect.
+	int64 ServerId = INDEX_NONE;
+};
+
+/**
+ * FSubscriptionManager
+ *
+ * Multiplexes every pubsub subscription over a single websocket to the selected network.
+ * Subscriptions are replayed automatically when the socket reconnects.
+ */
+class FOUNDATION_API FSubscriptionManager
+{
+public:
+
+	static uint32 SubscribeAccount(const FString& PubKey, SubscriptionCallback Callback, const FString& Encoding = TEXT("base64"), const FString& Commitment = TEXT("confirmed"));
+	static uint32 SubscribeProgram(const FString& ProgramId, const FString& Filters, SubscriptionCallback Callback, const FString& Encoding = TEXT("base64"), const FString& Commitment = TEXT("confirmed"));
+	static uint32 SubscribeSignature(const FString& Signature, SubscriptionCallback Callback, const FString& Commitment = TEXT("confirmed"));
+	static uint32 SubscribeSlot(SubscriptionCallback Callback);
+
+	// Params is the raw JSON array sent with Method, e.g. ["<pubkey>",{"encoding":"base64"}].
+	static uint32 Subscribe(const FString& Method, const FString& Params, SubscriptionCallback Callback, bool bOneShot = false);
+	static void Unsubscribe(uint32 Handle);
+
+	static bool IsConnected();
+
+	static void Shutdown();
+
+private:
+
+	static void Connect();
+	static void CloseSocket();
+	static void ScheduleReconnect();
+	static bool OnReconnectTimer(float DeltaTime);
+
+	static void SendSubscribe(uint32 Handle, const FSubscriptionData& Subscription);
+	static void SendUnsubscribe(const FString& Method, int64 ServerId);
+	static void SendMessage(const FString& Message);
+
+	static void OnConnected();
+	static void OnConnectionError(const FString& Error);
+	static void OnClosed(int32 StatusCode, const FString& Reason, bool bWasClean);
+	static void OnMessage(const FString& Message);
+};
@@ -0,0 +1,49 @@
+/*
+Copyright 2022 ATMTA, Inc.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+	http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+*/
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Network/ConfirmationTracker.h"
+
+struct FBlockhashInfo;
+class FSolanaRpcClient;
+
+/**
+ * FTransactionSender
+ *
+ * Lands signed transactions under congestion, when a single sendTransaction is often dropped. The same signed
+ * bytes are sent again on an interval until the transaction is confirmed, or until the block height passes the
+ * lastValidBlockHeight of its blockhash. It is then reported Expired and can be signed again with a fresh blockhash.
+ */
+class FOUNDATION_API FTransactionSender
+{
+public:
+
+	// Send a transaction signed with Blockhash and follow it through FConfirmationTracker. Returns its signature.
+	// A null client sends through the default one.
+	static FString Send(const TArray<uint8>& Transaction, const FBlockhashInfo& Blockhash, TransactionStatusCallback Callback, const TSharedPtr<FSolanaRpcClient>& Client = nullptr);
+
+	static void Shutdown();
+
+private:
+
+	static bool OnRebroadcastTimer(float DeltaTime);
+	static void SendOnce(const FString& Signature, bool bFirstSend);
+	static void RequestBlockHeight(const TSharedRef<FSolanaRpcClient>& Client);
+	static void OnBlockHeightReceived(const FSolanaRpcClient* Client, uint64 BlockHeight);
+	static void Stop(const FString& Signature);
+};
@@ -18,6 +18,7 @@ Contributers: Daniele Calanna, Riccardo Torrisi
 */
 #pragma once
 
+#include "SolanaUtils/PublicKey.h"
 #include "Account.generated.h"
 
 USTRUCT(BlueprintType)
@@ -33,24 +34,37 @@ struct FOUNDATION_API FAccount
 	UPROPERTY(SaveGame,BlueprintReadOnly)
 	int32 GenIndex = -1;
 
+	// Base58 forms of the binary keys, encoded once by the factories and loading. Blueprints and save games read them directly.
 	UPROPERTY(SaveGame, BlueprintReadOnly)
 	FString PublicKey;
 	UPROPERTY(SaveGame, BlueprintReadOnly)
 	FString PrivateKey;
 
-	TArray<uint8> PublicKeyData;
+	// Only set through the factories, which keep the base58 keys in step.
+	FPublicKey PublicKeyData;
 	TArray<uint8> PrivateKeyData;
 
-	TArray<uint8> Sign(const TArray<uint8>& Transaction);
-	void Verify(const TArray<uint8>& Transaction, const TArray<uint8>& Signature);
+	const FString& GetPublicKey() const { return PublicKey; }
+	// Empty for accounts made from a public key alone.
+	const FString& GetPrivateKey() const { return PrivateKey; }
+
+	bool HasPrivateKey() const;
+
+	FSignature Sign(TConstArrayView<uint8> Transaction) const;
+	void Verify(const TArray<uint8>& Transaction, const FSignature& Signature) const;
+
+	// Only the base58 keys are saved, the binary ones are rebuilt from them.
+	void PostSerialize(const FArchive& Ar);
 
 	static FAccount FromSeed(const TArray<uint8>& Seed);
 
 	static FAccount FromPrivateKey(const FString& PrivateKey);
 	static FAccount FromPrivateKey(const TArray<uint8>& PrivateKey);
 
-	static FAccount FromPublicKey(const FString& PrivateKey);
+	// Fails, leaving OutAccount untouched, unless PublicKey is exactly 32 bytes of base58.
+	static bool TryFromPublicKey(const FString& PublicKey, FAccount& OutAccount);
 	static FAccount FromPublicKey(const TArray<uint8>& PublicKey);
+	static FAccount FromPublicKey(const FPublicKey& PublicKey);
 
 	static bool IsBase58PrivateKey(const FString& Key);
 	static bool IsBytePrivateKey(const FString& Key);
@@ -58,5 +72,17 @@ struct FOUNDATION_API FAccount
 	static TArray<uint8> FStringToByteKey(const FString& Key);
 
 	static FString GetShortDisplayablePublicKey(const FString& PublicKey, int32 InitialCharsCount=6, int32 FinalCharsCount=4);
-	
+
+private:
+
+	void EncodeBase58Keys();
+};
+
+template<>
+struct TStructOpsTypeTraits<FAccount> : public TStructOpsTypeTraitsBase2<FAccount>
+{
+	enum
+	{
+		WithPostSerialize = true
+	};
 };
@@ -0,0 +1,98 @@
+/*
+Copyright 2022 ATMTA, Inc.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+	http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+*/
+#pragma once
+
+#include "CoreMinimal.h"
+#include "PublicKey.generated.h"
+
+/**
+ * FPublicKey
+ *
+ * A 32 byte ed25519 public key held inline. Keys compare with memcmp and hash their bytes directly,
+ * so they can key maps and be matched during transaction compilation without touching the heap.
+ * The base58 form is only produced when asked for.
+ */
+USTRUCT()
+struct FOUNDATION_API FPublicKey
+{
+	GENERATED_BODY()
+
+	static constexpr int32 Size = 32;
+
+	FPublicKey() { FMemory::Memzero(Bytes); }
+	explicit FPublicKey(const uint8* Data) { FMemory::Memcpy(Bytes, Data, Size); }
+
+	// Shorter data is zero padded at the end, longer data truncated.
+	static FPublicKey FromBytes(const TArray<uint8>& Data);
+	// For keys known to be valid, such as program ids. Anything that is not exactly 32 bytes of base58 ensures and gives
+	// the zero key, which is the system program, so user and RPC input must go through TryFromBase58.
+	static FPublicKey FromBase58(const FString& Key);
+	static bool TryFromBase58(const FString& Key, FPublicKey& OutKey);
+
+	FString ToBase58() const;
+	TArray<uint8> ToArray() const { return TArray<uint8>(Bytes, Size); }
+
+	const uint8* GetData() const { return Bytes; }
+	uint8* GetData() { return Bytes; }
+
+	bool IsZero() const;
+
+	bool operator==(const FPublicKey& Other) const { return FMemory::Memcmp(Bytes, Other.Bytes, Size) == 0; }
+	bool operator!=(const FPublicKey& Other) const { return !(*this == Other); }
+
+	friend uint32 GetTypeHash(const FPublicKey& Key);
+
+	UPROPERTY()
+	uint8 Bytes[32];
+};
+
+template<>
+struct TStructOpsTypeTraits<FPublicKey> : public TStructOpsTypeTraitsBase2<FPublicKey>
+{
+	enum
+	{
+		WithIdenticalViaEquality = true
+	};
+};
+
+/**
+ * FSignature
+ *
+ * A 64 byte ed25519 signature held inline. The first signature of a transaction is also its id.
+ */
+struct FOUNDATION_API FSignature
+{
+	static constexpr int32 Size = 64;
+
+	FSignature() { FMemory::Memzero(Bytes); }
+	explicit FSignature(const uint8* Data) { FMemory::Memcpy(Bytes, Data, Size); }
+
+	static FSignature FromBase58(const FString& Signature);
+
+	FString ToBase58() const;
+	TArray<uint8> ToArray() const { return TArray<uint8>(Bytes, Size); }
+
+	const uint8* GetData() const { return Bytes; }
+	uint8* GetData() { return Bytes; }
+
+	bool operator==(const FSignature& Other) const { return FMemory::Memcmp(Bytes, Other.Bytes, Size) == 0; }
+	bool operator!=(const FSignature& Other) const { return !(*this == Other); }
+
+	friend uint32 GetTypeHash(const FSignature& Signature);
+
+	uint8 Bytes[64];
+};
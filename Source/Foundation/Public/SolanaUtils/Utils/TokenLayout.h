@@ -0,0 +1,71 @@
+/*
+Copyright 2022 ATMTA, Inc.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+	http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+*/
+#pragma once
+
+#include "CoreMinimal.h"
+#include "SolanaUtils/Utils/Types.h"
+
+constexpr int32 MintAccountSize = 82;
+constexpr int32 MintDecimalsOffset = 44;
+constexpr int32 TokenAmountOffset = 64;
+
+/**
+ * FTokenAccountLayout
+ *
+ * An SPL token account decoded straight from its fixed 165 byte layout, without going through jsonParsed.
+ */
+struct FOUNDATION_API FTokenAccountLayout
+{
+	uint8 Mint[PublicKeySize] = {};
+	uint8 Owner[PublicKeySize] = {};
+	uint64 Amount = 0;
+
+	bool bHasDelegate = false;
+	uint8 Delegate[PublicKeySize] = {};
+
+	// 0 uninitialized, 1 initialized, 2 frozen.
+	uint8 State = 0;
+
+	// Wrapped SOL accounts hold this many lamports for rent exemption.
+	bool bIsNative = false;
+	uint64 NativeReserve = 0;
+
+	uint64 DelegatedAmount = 0;
+
+	bool bHasCloseAuthority = false;
+	uint8 CloseAuthority[PublicKeySize] = {};
+
+	static bool Decode(const uint8* Data, int32 Size, FTokenAccountLayout& OutAccount);
+	static bool DecodeBase64(const FString& Data, FTokenAccountLayout& OutAccount);
+
+	// Read the decimals of a mint from its account data, or from a slice starting at MintDecimalsOffset.
+	static bool DecodeMintDecimals(const uint8* Data, int32 Size, bool bSliced, uint8& OutDecimals);
+
+	// Read the amount of a token account from its account data, or from a slice starting at TokenAmountOffset.
+	static bool DecodeAmount(const uint8* Data, int32 Size, bool bSliced, uint64& OutAmount);
+
+	FString GetMint() const;
+	FString GetOwner() const;
+	double GetUIAmount(uint8 Decimals) const;
+};
+
+// A token account along with its own address.
+struct FTokenAccountEntry
+{
+	FString Pubkey;
+	FTokenAccountLayout Account;
+};
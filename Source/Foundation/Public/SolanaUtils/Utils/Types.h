@@ -53,6 +53,22 @@ struct FBalanceResultJson
 	UPROPERTY()	double value;
 };
 
+USTRUCT()
+struct FBlockhashValueJson
+{
+	GENERATED_BODY()
+	UPROPERTY()	FString blockhash;
+	UPROPERTY()	double lastValidBlockHeight;
+};
+
+USTRUCT()
+struct FLatestBlockhashJson
+{
+	GENERATED_BODY()
+	UPROPERTY()	FBalanceContextJson context;
+	UPROPERTY()	FBlockhashValueJson value;
+};
+
 USTRUCT()
 struct FAccountInfoJson
 {
@@ -70,6 +86,7 @@ struct FProgramAccountJson
 {
 	GENERATED_BODY()
 
+	UPROPERTY()	FString pubkey;
 	UPROPERTY()	FString data;
 	UPROPERTY()	bool executable;
 	UPROPERTY()	double lamports;
@@ -42,6 +42,9 @@ struct FAccountData
 	
 	UPROPERTY(BlueprintReadOnly)
 	int64 Balance = 0;
+
+	UPROPERTY(BlueprintReadOnly)
+	uint8 Decimals = 0;
 };
 
 UCLASS()
@@ -24,6 +24,7 @@ Contributers: Riccardo Torrisi, Federico Arona
 #include "SolanaWallet.generated.h"
 
 class UWalletAccount;
+class FSolanaRpcClient;
 
 /**
  * FDerivationPath
@@ -222,7 +223,7 @@ public:
 	UFUNCTION(BlueprintCallable, Category="Account")
 	UWalletAccount* ImportAccountFromPrivateKey(FString PrivateKey);
 
-	// Create an account from a public key.
+	// Create an account from a public key. Null if the key is not valid base58.
 	UFUNCTION(BlueprintCallable, Category="Account")
 	UWalletAccount* ImportAccountFromPublicKey(FString PublicKey);
 
@@ -261,6 +262,15 @@ public:
 	UFUNCTION(BlueprintCallable, Category="Account")
 	void UpdateTokenAccounts();
 
+	// Switch every account between websocket pushed balances and polling.
+	UFUNCTION(BlueprintCallable, Category="Account")
+	void SetLiveUpdates(bool bEnabled);
+
+	// Send the RPC calls of this wallet and its accounts through Client, for instance to keep it on another network.
+	// A null client goes back to the default one.
+	void SetRpcClient(const TSharedPtr<FSolanaRpcClient>& Client) { RpcClient = Client; }
+	TSharedRef<FSolanaRpcClient> GetRpcClient() const;
+
 	// Copy the string parameter to the system clipboard.
 	UFUNCTION(BlueprintCallable)
 	static void ClipboardCopy(FString String);
@@ -274,7 +284,7 @@ private:
 	FMnemonic Mnemonic;
 
 	UPROPERTY()
-	TMap<FString, UWalletAccount*> Accounts;
+	TMap<FPublicKey, UWalletAccount*> Accounts;
 
 	UPROPERTY()
 	UWalletData* CurrentSaveData;
@@ -288,6 +298,8 @@ private:
 	UPROPERTY()
 	TArray<FString> PublicKeys;
 
+	TSharedPtr<FSolanaRpcClient> RpcClient;
+
 	static FText WalletLockedText;
 	static FText InvalidMnemonic;
 };
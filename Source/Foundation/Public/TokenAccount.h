@@ -47,4 +47,16 @@ public:
 	UFUNCTION(BlueprintCallable)
 	void Send(FString PublicKey, float Amount);
 
+	// Receive balance changes pushed over the websocket instead of polling.
+	UFUNCTION(BlueprintCallable)
+	void SetLiveUpdates(bool bEnabled);
+
+	UFUNCTION(BlueprintPure)
+	bool HasLiveUpdates() const { return Subscription != 0; }
+
+	virtual void BeginDestroy() override;
+
+private:
+
+	uint32 Subscription = 0;
 };
@@ -25,6 +25,9 @@ Contributers: Riccardo Torrisi, Federico Arona
 #include "WalletAccount.generated.h"
 
 class UTokenAccount;
+struct FTokenAccountLayout;
+struct FBlockhashInfo;
+enum class ETransactionStatus : uint8;
 
 /**
  * UWalletAccount
@@ -59,7 +62,7 @@ public:
 	FString GetAccountName() const { return AccountData.Name; }
 
 	UFUNCTION(BlueprintPure)
-	FString GetPublicKey() const { return AccountData.PublicKey; }
+	FString GetPublicKey() const { return AccountData.GetPublicKey(); }
 
 	UFUNCTION(BlueprintCallable)
 	void SetAccountName(const FString& Name);
@@ -86,6 +89,16 @@ public:
 	void UpdateTokenAccounts();
 
 	void UpdateFromAccountInfoJson(const FAccountInfoJson& AccountInfoJson);
+	void UpdateTokenAccount(const FString& Pubkey, const FString& Mint, double Balance, uint8 Decimals);
+
+	// Receive SOL and token balance changes pushed over the websocket instead of polling.
+	UFUNCTION(BlueprintCallable)
+	void SetLiveUpdates(bool bEnabled);
+
+	UFUNCTION(BlueprintPure)
+	bool HasLiveUpdates() const { return AccountSubscription != 0; }
+
+	virtual void BeginDestroy() override;
 
 	// TODO support UTokenAccount
 	void SendSOL(const FAccount& from, const FAccount& to, int64 amount) const;
@@ -97,6 +110,21 @@ public:
 	UFUNCTION(BlueprintCallable)
 	void SendTokenEstimate(UTokenAccount* TokenAccount, const FString& RecipientPublicKey, float Amount) const;
 
+	// Progress of the transactions sent from this account, from processed to finalized, failed or expired.
+	DECLARE_EVENT_TwoParams(UWalletAccount, FOnTransactionStatus, const FString& /*Signature*/, ETransactionStatus /*Status*/);
+	FOnTransactionStatus OnTransactionStatus;
+
 	UFUNCTION(BlueprintPure)
 	USolanaWallet* GetOwningWallet() const { return CastChecked<USolanaWallet>(GetOuter()); }
+
+private:
+
+	void UpdateTokenAccountFromLayout(const FString& Pubkey, const FTokenAccountLayout& Layout);
+	// Fallback for mints whose decimals could not be read: their accounts are read again with the parsed encoding.
+	void UpdateParsedTokenAccounts(const TSet<FString>& Mints, TFunction<void()> OnComplete);
+	void InvalidateCachedReads(const FJsonObject& Notification) const;
+	void SendTransaction(const TArray<uint8>& Transaction, const FBlockhashInfo& Blockhash) const;
+
+	uint32 AccountSubscription = 0;
+	uint32 TokenAccountsSubscription = 0;
 };